@@ -0,0 +1,145 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <vector>
+
+#include "../../Spike-Tools-LIB/assert.ipp"
+
+#include "SpikeOptionsStatic.hpp"
+#include "Types.hpp"
+#include "TimingWheel.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// a spike of the origin that travels over all its outgoing synapses of one delay group, see Synapses::getOutgoingDelayGroups
+		struct AxonalEvent
+		{
+			KernelTime kerneltime; // arrival time at the destinations
+			NeuronId origin;
+			unsigned int delayGroup; // index in the delay groups of the origin
+
+			// constructor
+			AxonalEvent(
+				const KernelTime kerneltime,
+				const NeuronId origin,
+				const unsigned int delayGroup
+			): kerneltime(kerneltime)
+				, origin(origin)
+				, delayGroup(delayGroup)
+			{
+			}
+		};
+
+		// Fired spikes that have not yet arrived, one event per origin and delay group instead of one incomming spike per synapse.
+		// The events are kept in a timing wheel; when the time is advanced, the events that become due are handed to the caller
+		// in order of arrival time, who expands them into incomming spikes.
+		template <typename Topology_i>
+		class AxonalEventQueue
+		{
+		public:
+
+			using Topology = Topology_i;
+			using Options = typename Topology_i::Options;
+
+			// constructor
+			AxonalEventQueue()
+				: events_(TimingWheel<AxonalEvent>(nSlots))
+				, currentTime_(0)
+			{
+			}
+
+			// remove all events and go back to time zero, the allocated memory is retained
+			void clear()
+			{
+				this->events_.clear();
+				this->currentTime_ = 0;
+			}
+
+			void sheduleAxonalEvent(const KernelTime kerneltime, const NeuronId origin, const unsigned int delayGroup)
+			{
+				::tools::assert::assert_msg(kerneltime >= this->currentTime_, "spike::v3::AxonalEventQueue::sheduleAxonalEvent: event time ", kerneltime, " is before current time ", this->currentTime_);
+				::tools::assert::assert_msg((kerneltime - this->currentTime_) < static_cast<KernelTime>(this->events_.getNumberOfSlots()), "spike::v3::AxonalEventQueue::sheduleAxonalEvent: event time ", kerneltime, " is too far in the future; currentTime ", this->currentTime_);
+				this->events_.add(kerneltime, AxonalEvent(kerneltime, origin, delayGroup));
+			}
+
+			// call expand for every event that arrives before the provided future time, in order of arrival time
+			template <typename F>
+			void advanceCurrentTime(const KernelTime futureTime, const F& expand)
+			{
+				for (KernelTime t = this->currentTime_; t < futureTime; ++t)
+				{
+					if (this->events_.empty()) break;
+
+					for (const AxonalEvent& event : this->events_.getSlot(t))
+					{
+						expand(event);
+					}
+					this->events_.clearSlot(t);
+				}
+				this->currentTime_ = futureTime;
+			}
+
+			// return the time of the earliest event, LAST_KERNEL_TIME if there is none
+			KernelTime getNextSpikeTime() const
+			{
+				return this->events_.getNextOccupiedTime(this->currentTime_);
+			}
+
+			void substractTime(const KernelTime time)
+			{
+				// the slot of an event depends on its time: reschedule all events
+				const std::vector<AxonalEvent> events = this->events_.getAll();
+				this->events_.clear();
+				for (AxonalEvent event : events)
+				{
+					event.kerneltime -= time;
+					this->events_.add(event.kerneltime, event);
+				}
+				this->currentTime_ -= time;
+			}
+
+			// return the number of scheduled events
+			size_t size() const
+			{
+				return this->events_.size();
+			}
+
+			// return the number of bytes allocated
+			size_t getMemoryUsage() const
+			{
+				return this->events_.getMemoryUsage();
+			}
+
+		private:
+
+			// a spike fired in the window [t, t+minDelay] arrives at most maxDelay after the end of the window
+			static const size_t nSlots = static_cast<size_t>(Options::toKernelTime(static_cast<TimeInMs>(Options::maxDelay + Options::minDelay))) + 1;
+
+			TimingWheel<AxonalEvent> events_;
+			KernelTime currentTime_;
+		};
+	}
+}
@@ -0,0 +1,166 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <chrono>		// std::chrono::steady_clock
+
+#include "omp.h"
+
+#include "../../Spike-Tools-LIB/SpikeNetworkPerformance.hpp"
+
+#include "Types.hpp"
+#include "Network3.hpp"
+#include "SpikeStreamDataSet.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// Evaluate many cases against a frozen network. Every thread has one network, which shares the read-only synapses and
+		// is reset to time zero (Network3::resetCase) before each of its cases; the neuron state, the queues and the kernel
+		// tables are only allocated once per thread. The cases are distributed over the OpenMP threads; the motor spike counts
+		// are merged in the order of the provided case ids, such that the confusion matrix does not depend on the number of
+		// threads. With Options::decisionPolicy a case ends when a motor neuron has won.
+		template <typename Topology_i, typename SpikeQueue_i = IncommingSpikeQueue<Topology_i>, typename Synapses_i = Synapses<Topology_i>>
+		class BatchEvaluator
+		{
+		public:
+
+			using Topology = Topology_i;
+			using SpikeQueue = SpikeQueue_i;
+			using Synapses = Synapses_i;
+			using Options = typename Topology_i::Options;
+			using SpikeStream = SpikeStreamDataSet<Topology>;
+			using Network = Network3<Topology, SpikeStream, SpikeQueue, Synapses>;
+			using Performance = SpikeNetworkPerformance<Topology, TimeInMs>;
+
+			static_assert(Options::inferenceOnly, "BatchEvaluator: the networks share the synapses, which requires the read-only weights of Options::inferenceOnly");
+			static_assert(Options::randomSpikeGenerator == RandomSpikeGenerator::COUNTER_BASED, "BatchEvaluator: the networks run concurrently, which requires the per neuron random streams of RandomSpikeGenerator::COUNTER_BASED");
+			static_assert(Topology::Nm == Performance::S, "BatchEvaluator: the confusion matrix needs one motor neuron per case label");
+
+			// constructor
+			BatchEvaluator(
+				const Options& options,
+				const SpikeRuntimeOptions& spikeRuntimeOptions,
+				const std::shared_ptr<Topology>& topology,
+				const std::shared_ptr<const SpikeStream>& cases
+			)
+				: options_(options)
+				, spikeRuntimeOptions_(spikeRuntimeOptions)
+				, topology_(topology)
+				, synapses_(std::make_shared<Synapses>())
+				, cases_(cases)
+			{
+				this->synapses_->init(topology);
+			}
+
+			// run the provided cases on nThreads threads and return the confusion matrix of the motor neurons that fired
+			Performance evaluate(const std::vector<CaseId>& caseIds, const int nThreads) const
+			{
+				const auto t1 = std::chrono::steady_clock::now();
+
+				const int nCases = static_cast<int>(caseIds.size());
+				std::vector<CaseResult> results(nCases);
+
+				#pragma omp parallel num_threads(nThreads)
+				{
+					// on the heap: the state of a network is too large for the stack of a thread
+					const std::shared_ptr<Network> network = std::make_shared<Network>(this->options_, this->spikeRuntimeOptions_);
+					network->setTopology(this->topology_, this->synapses_);
+					network->setNumberOfThreads(1); // the cases are the unit of parallelism
+
+					#pragma omp for schedule(dynamic, 1)
+					for (int i = 0; i < nCases; ++i)
+					{
+						results[i] = this->evaluateCase(*network, caseIds[i]);
+					}
+				}
+
+				// merge serially in the order of the case ids
+				Performance performance;
+				TimeInMs simulatedTime = 0;
+				int nDecided = 0;
+				int nDecidedCorrect = 0;
+				for (const CaseResult& result : results)
+				{
+					const CaseOccurance<TimeInMs>& caseOccurance = result.caseOccurance;
+					performance.addPerformance(CaseLabel(caseOccurance.caseLabel_), result.motorSpikeCount);
+					simulatedTime += caseOccurance.endTime_ - caseOccurance.startTime_;
+					if (CaseLabel(caseOccurance.decisionLabel_) != NO_CASE_LABEL)
+					{
+						nDecided++;
+						if (caseOccurance.decisionLabel_ == caseOccurance.caseLabel_) nDecidedCorrect++;
+					}
+				}
+
+				const auto t2 = std::chrono::steady_clock::now();
+				const double diff = std::chrono::duration<double, std::milli>(t2 - t1).count();
+				printf("spike::v3::BatchEvaluator::evaluate: %d cases in %.0f ms wall with %d threads; %.1f ms simulated per case; avg precision %5.4f\n", nCases, diff, nThreads, (nCases == 0) ? 0.0 : (simulatedTime / nCases), performance.getAveragePrecision());
+				if (Options::decisionPolicy != DecisionPolicy::NONE)
+				{
+					printf("spike::v3::BatchEvaluator::evaluate: %d of %d cases decided early, %.1f%% of the decisions correct\n", nDecided, nCases, (nDecided == 0) ? 0.0 : (100.0 * nDecidedCorrect / nDecided));
+				}
+				return performance;
+			}
+
+			// run all cases of the data set
+			Performance evaluate(const int nThreads) const
+			{
+				return this->evaluate(this->cases_->getCaseIds(), nThreads);
+			}
+
+		private:
+
+			struct CaseResult
+			{
+				std::array<unsigned int, Topology::Nm> motorSpikeCount;
+				CaseOccurance<TimeInMs> caseOccurance; // with the decision and its latency
+			};
+
+			const Options options_;
+			const SpikeRuntimeOptions spikeRuntimeOptions_;
+			const std::shared_ptr<Topology> topology_;
+			const std::shared_ptr<Synapses> synapses_; // read-only: shared by all networks
+			const std::shared_ptr<const SpikeStream> cases_;
+
+			CaseResult evaluateCase(Network& network, const CaseId caseId) const
+			{
+				const SpikeCaseStore<Options>& cases = this->cases_->getCaseStore();
+				const auto spikeStream = std::make_shared<SpikeStream>(this->spikeRuntimeOptions_);
+				spikeStream->add(cases, caseId);
+				spikeStream->start();
+
+				network.resetCase();
+				network.setSpikeStream(spikeStream);
+
+				CaseResult result;
+				result.motorSpikeCount = network.runCase(Options::toKernelTime(cases.getCase(cases.getIndex(caseId)).getDurationPlusSilence()));
+				result.caseOccurance = spikeStream->getCaseUsage().front();
+				return result;
+			}
+		};
+	}
+}
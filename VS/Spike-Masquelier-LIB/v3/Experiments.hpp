@@ -386,4 +386,4 @@ namespace spike
 			}
 		}
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,185 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <tuple>
+#include <cmath>
+
+#include "Types.hpp"
+#include "SpikeOptionsStatic.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// Epsilon part of the membrane potential carried as two exponentially decaying state variables per neuron.
+		//
+		// The epsilon kernel is k*(exp(-t/tau_m) - exp(-t/tau_s)), hence the sum over the incomming spikes i equals
+		// k*(m*exp(-t/tau_m) - s*exp(-t/tau_s)) with m = sum w_i*exp(t_i/tau_m) and s = sum w_i*exp(t_i/tau_s).
+		// The state (m, s) of a neuron holds the spikes that arrived before its reference time, relative to that time.
+		// The state is brought up to date lazily when the voltage of the neuron is requested: it is decayed from the
+		// reference time to the start of the current window, the spikes in between are folded in, and the reference time
+		// becomes the window start. The spikes of the current window (which may be in the future of the evaluation time)
+		// are summed explicitly. Neurons that are not tested cost nothing; the state is reset when the neuron fires.
+		//
+		// Difference with the exact kernel: the state is exact up to float rounding; spikes that expire from the queue
+		// (older than kernelRangeEpsilonInMs) before the neuron is read are not folded in, the error per spike is at most
+		// epsilon(kernelRangeEpsilonInMs) = exp(-10) - exp(-25) = 4.54e-5 (tau_m=10, tau_s=4, k=1, range 100 ms). The table
+		// sum of Network3::calcVoltage is truncated at that range, and it stops at the first spike in the future, which
+		// skips the past spikes behind it when the spikes of a window are not sorted. Set Options::checkVoltageEngine to
+		// measure the deviation of an engine with the exact kernel sum during a run.
+		template <typename Topology_i>
+		class ExponentialVoltageState
+		{
+		public:
+
+			using Topology = Topology_i;
+			using Options = typename Topology_i::Options;
+
+			// constructor
+			ExponentialVoltageState()
+				: windowStart_(0)
+				, decayM_(std::vector<float>(tableSize))
+				, decayS_(std::vector<float>(tableSize))
+			{
+				for (size_t i = 0; i < tableSize; ++i)
+				{
+					const TimeInMs t = Options::toTimeInMs(static_cast<KernelTime>(i));
+					this->decayM_[i] = static_cast<float>(std::exp(-t / Options::tau_m));
+					this->decayS_[i] = static_cast<float>(std::exp(-t / Options::tau_s));
+				}
+				this->clear();
+			}
+
+			// remove the state of all neurons and go back to time zero; the decay tables are retained
+			void clear()
+			{
+				this->windowStart_ = 0;
+				this->m_.fill(0);
+				this->s_.fill(0);
+				this->referenceTime_.fill(0);
+			}
+
+			// make newWindowStart the start of the current window; the state of the neurons is updated when they are read
+			void advance(const KernelTime newWindowStart)
+			{
+				::tools::assert::assert_msg(newWindowStart >= this->windowStart_, "spike::v3::ExponentialVoltageState::advance: time cannot go back; newWindowStart=", newWindowStart);
+				this->windowStart_ = newWindowStart;
+			}
+
+			// a spike removes the contributions of all previous incomming spikes
+			void reset(const NeuronId neuronId)
+			{
+				this->m_[neuronId] = 0;
+				this->s_[neuronId] = 0;
+				this->referenceTime_[neuronId] = this->windowStart_;
+			}
+
+			// return the epsilon part of the voltage of the provided neuron at the provided time in the current window; the spike
+			// records are relative to the provided base time. Concurrent calls are allowed for different neurons only.
+			template <typename SpikeRecord>
+			Voltage getVoltage(
+				const NeuronId neuronId,
+				const std::tuple<const SpikeRecord * const, unsigned int, unsigned int>& tuple,
+				const KernelTime baseTime,
+				const KernelTime kerneltime) const
+			{
+				const KernelTime referenceTime = this->referenceTime_[neuronId];
+				float m = this->m_[neuronId];
+				float s = this->s_[neuronId];
+				if (referenceTime < this->windowStart_)
+				{
+					const KernelTime dt = this->windowStart_ - referenceTime;
+					m *= this->getDecayM(dt);
+					s *= this->getDecayS(dt);
+				}
+
+				Voltage voltage = 0;
+				const SpikeRecord * const spikes = std::get<0>(tuple);
+				for (unsigned int i = std::get<2>(tuple); i > std::get<1>(tuple); --i)
+				{
+					const KernelTime spikeTime = spikes[i - 1].getKernelTime(baseTime);
+					if (spikeTime < referenceTime) break;
+					const Efficacy efficacy = spikes[i - 1].getEfficacy();
+					if (spikeTime < this->windowStart_)
+					{	// a spike of a window after the reference time: fold it into the state
+						const KernelTime relativeTime = this->windowStart_ - spikeTime;
+						m += efficacy * this->getDecayM(relativeTime);
+						s += efficacy * this->getDecayS(relativeTime);
+					}
+					else
+					{
+						const KernelTime relativeTime = kerneltime - spikeTime;
+						if (relativeTime > 0)
+						{
+							voltage += efficacy * Options::k * (this->getDecayM(relativeTime) - this->getDecayS(relativeTime));
+						}
+					}
+				}
+				this->m_[neuronId] = m;
+				this->s_[neuronId] = s;
+				this->referenceTime_[neuronId] = this->windowStart_;
+
+				const KernelTime dt = kerneltime - this->windowStart_;
+				return voltage + (Options::k * ((m * this->getDecayM(dt)) - (s * this->getDecayS(dt))));
+			}
+
+			void substractTime(const KernelTime time)
+			{
+				this->windowStart_ -= time;
+				for (KernelTime& referenceTime : this->referenceTime_)
+				{
+					referenceTime -= time;
+				}
+			}
+
+		private:
+
+			// the decays within the epsilon kernel range plus one window are looked up; longer decays (of neurons that were
+			// not read for a long time) are computed
+			static const size_t tableSize = static_cast<size_t>(Options::toKernelTime(Options::kernelRangeEpsilonInMs + static_cast<TimeInMs>(Options::minDelay))) + 1;
+
+			KernelTime windowStart_;
+
+			// mutable: the state of a neuron is brought up to date when it is read, instead of advancing all neurons each window
+			mutable std::array<float, Options::nNeurons> m_;
+			mutable std::array<float, Options::nNeurons> s_;
+			mutable std::array<KernelTime, Options::nNeurons> referenceTime_; // the spikes before this time are in (m_, s_), relative to this time
+
+			std::vector<float> decayM_;
+			std::vector<float> decayS_;
+
+			float getDecayM(const KernelTime dt) const
+			{
+				return (static_cast<size_t>(dt) < tableSize) ? this->decayM_[dt] : static_cast<float>(std::exp(-Options::toTimeInMs(dt) / Options::tau_m));
+			}
+
+			float getDecayS(const KernelTime dt) const
+			{
+				return (static_cast<size_t>(dt) < tableSize) ? this->decayS_[dt] : static_cast<float>(std::exp(-Options::toTimeInMs(dt) / Options::tau_s));
+			}
+		};
+	}
+}
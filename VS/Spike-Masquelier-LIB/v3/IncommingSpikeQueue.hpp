@@ -24,10 +24,12 @@
 
 #include <vector>
 #include <tuple>
+#include <algorithm>
 
 #include "SpikeOptionsStatic.hpp"
 #include "Types.hpp"
-#include "SpikeHistory.hpp"
+#include "NeuronStateBlocks.hpp"
+#include "IncommingSpikeStore.hpp"
 
 namespace spike 
 {
@@ -248,97 +250,91 @@ namespace spike
 		};
 		*/
 
-		template <typename Topology_i>
+		template <typename Topology_i, typename SpikeRecord_i = IncommingSpike>
 		class IncommingSpikeQueue {
 		public:
 
 			using Topology = Topology_i;
 			using Options = typename Topology_i::Options;
+			using SpikeRecord = SpikeRecord_i; // record of the past and near future spikes, IncommingSpike or PackedIncommingSpike
 
 			// constructor
 			IncommingSpikeQueue()
-				: pastAndNearFutureSpikes_(std::vector<IncommingSpike>(Options::nNeurons * maxNumberOfSpikes))
-				, spikesTmp_(std::vector<IncommingSpike>(Options::nNeurons * maxNumberOfSpikes))
-
-				, farFutureSpikes_(std::vector<IncommingSpike>(Options::nNeurons * maxNumberOfSpikes))
-				, farFutureSpikesLength_(0)
-
-				, nearFutureSpikes_(std::vector<IncommingSpike>(Options::nNeurons * maxNumberOfSpikes))
-				, nearFutureSpikesLength_(0)
+				: farFutureSpikes_(std::vector<IncommingSpike>())
+				, nearFutureSpikes_(std::vector<IncommingSpike>())
 				, currentTime_(0)
+				, timeHorizon_(-Options::toKernelTime(Options::kernelRangeEpsilonInMs))
+				, nextFarFutureTime_(LAST_KERNEL_TIME)
 			{
-				for (NeuronId neuronId = 0; neuronId < Options::nNeurons; ++neuronId) {
-					this->cleanup(neuronId);
-				}
+			}
+
+			// remove all spikes and go back to time zero, the allocated memory is retained
+			void clear()
+			{
+				this->pastAndNearFutureSpikes_.clear();
+				this->farFutureSpikes_.clear();
+				this->nearFutureSpikes_.clear();
+				this->currentTime_ = 0;
+				this->timeHorizon_ = -Options::toKernelTime(Options::kernelRangeEpsilonInMs);
+				this->nextFarFutureTime_ = LAST_KERNEL_TIME;
 			}
 
 			void sheduleIncommingSpike(const KernelTime kerneltime, const NeuronId origin, const NeuronId destination, const Efficacy efficacy)
 			{
 				::tools::assert::assert_msg(kerneltime != NO_KERNEL_TIME, "not allowed to shedule NO_KERNEL_TIME");
-				this->farFutureSpikes_[this->farFutureSpikesLength_] = IncommingSpike(kerneltime, origin, destination, efficacy);
-				this->farFutureSpikesLength_++;
-				if (this->farFutureSpikesLength_ >= (Options::nNeurons * maxNumberOfSpikes)) {
-					std::cout << "spike::v3::IncommingSpikeQueue::sheduleIncommingSpike: too many spikes" << std::endl;
-					__debugbreak();
-					this->farFutureSpikesLength_ = 0;
-				}
+				this->farFutureSpikes_.push_back(IncommingSpike(kerneltime, origin, destination, efficacy));
+				this->nextFarFutureTime_ = std::min(this->nextFarFutureTime_, kerneltime);
 			}
 
-			const std::tuple<const IncommingSpike * const, unsigned int, unsigned int> getPastAndNearFutureSpikes(const NeuronId neuronId) const
+			const std::tuple<const SpikeRecord * const, unsigned int, unsigned int> getPastAndNearFutureSpikes(const NeuronId neuronId) const
 			{
+				this->expire(neuronId);
 				// the past spike also contain future spike that cannot be reorded, accept for by random future spikes
-				const std::tuple<unsigned int, unsigned int>& tuple = this->pastAndNearFutureSpikesStartEndPos_[neuronId];
-				return std::make_tuple(this->pastAndNearFutureSpikes_.data(), std::get<0>(tuple), std::get<1>(tuple));
+				return this->pastAndNearFutureSpikes_.getSpikes(neuronId);
 			}
 
 			void cleanup(const NeuronId neuronId)
 			{
-				const unsigned int beginPos = this->absoluteBeginPos(neuronId);
-				this->pastAndNearFutureSpikesStartEndPos_[neuronId] = std::make_tuple(beginPos, beginPos);
+				this->pastAndNearFutureSpikes_.clear(neuronId);
 			}
 
 			// return the near spikes that have been added by advancing the time
 			const std::tuple<const IncommingSpike * const, size_t, size_t> advanceCurrentTime(
 				const KernelTime futureTime,
-				const SpikeHistory4<Topology>& endRefractoryPeriods)
+				const NeuronStateBlocks<Topology>& neuronState)
 			{
 				if (Options::tranceNeuronOn) {
 					printf("spike::v3::IncommingSpikeQueueSlow::advanceCurrentTime: currentTime %5u; advancing time to %5u\n", this->currentTime_, futureTime);
 				}
-				this->cleanupPast(futureTime);// advance time for the past spikes
+				this->timeHorizon_ = futureTime - Options::toKernelTime(Options::kernelRangeEpsilonInMs); // the past spikes are expired when a neuron is touched
 
 				{ // advance time for the nearFuture and farFuture spikes
-					size_t newNearFutureSpikesLength = 0;
+					this->nearFutureSpikes_.clear();
+					this->nextFarFutureTime_ = LAST_KERNEL_TIME;
 					size_t newFarFutureSpikesLength = 0;
 
-					for (size_t i = 0; i < this->farFutureSpikesLength_; ++i) {
-						const IncommingSpike& spike = this->farFutureSpikes_[i];
+					for (size_t i = 0; i < this->farFutureSpikes_.size(); ++i) {
+						const IncommingSpike spike = this->farFutureSpikes_[i];
 						if (spike.kerneltime < futureTime) {
 							::tools::assert::assert_msg(spike.kerneltime >= this->currentTime_, "spike::v3::IncommingSpikeQueueSlow::advanceCurrentTime: adding a spike to the past that should have been added to the past much earlier. \ncurrentTime=", this->currentTime_, "; futureTime=", futureTime, "; spike.time=", spike.kerneltime, "; spike.origin=", spike.origin, "; spike.destination=", spike.destination);
-							this->nearFutureSpikes_[newNearFutureSpikesLength] = spike;
-							newNearFutureSpikesLength++;
+							this->nearFutureSpikes_.push_back(spike);
 
-							if (spike.kerneltime >= std::get<0>(endRefractoryPeriods.getSpikes(spike.destination))) { // do not add incomming spikes that occur during the refactory period
+							if (spike.kerneltime >= neuronState.getEndRefractoryPeriod(spike.destination)) { // do not add incomming spikes that occur during the refactory period
 								this->addToPastAndNearFuture(spike.destination, spike);
 							} else {
 								//std::cout << "spike::v3::IncommingSpikeQueue::advanceCurrentTime: IncommingSpike=" << next.toString() << "; endOfRefractoryPeriod=" << endOfRefractoryPeriod << std::endl;
 							}
-						} else {
-							this->spikesTmp_[newFarFutureSpikesLength] = spike;
+						} else { // keep the spike in the far future, the remaining far future spikes are moved to the front in place
+							this->farFutureSpikes_[newFarFutureSpikesLength] = spike;
 							newFarFutureSpikesLength++;
+							this->nextFarFutureTime_ = std::min(this->nextFarFutureTime_, spike.kerneltime);
 						}
 					}
-					for (size_t i = 0; i < newFarFutureSpikesLength; ++i) {
-						this->farFutureSpikes_[i] = this->spikesTmp_[i];
-					}
-
-					this->nearFutureSpikesLength_ = newNearFutureSpikesLength;
-					this->farFutureSpikesLength_ = newFarFutureSpikesLength;
+					this->farFutureSpikes_.resize(newFarFutureSpikesLength);
 				}
 
-
 				this->currentTime_ = futureTime;
-				return std::make_tuple(this->nearFutureSpikes_.data(), 0, this->nearFutureSpikesLength_);
+				return std::make_tuple(this->nearFutureSpikes_.data(), 0, this->nearFutureSpikes_.size());
 			}
 
 			void addToPastAndNearFuture(const NeuronId neuronId, const IncommingSpike spike)
@@ -346,120 +342,77 @@ namespace spike
 				if (Options::tranceNeuronOn && (neuronId == Options::tranceNeuron)) {
 					printf("spike::v3::IncommingSpikeQueueSlow::addToPastAndNearFuture: neuronId=%u; spike time %u\n", neuronId, spike.kerneltime);
 				}
-				std::tuple<unsigned int, unsigned int>& tuple = this->pastAndNearFutureSpikesStartEndPos_[neuronId];
-				unsigned int& endPos = std::get<1>(tuple);
-
-				if (endPos == this->absoluteEndPos(neuronId)) { // cleanup pastAndNearFutureSpikes_
-					const unsigned int beginPos = std::get<0>(tuple);
-					const unsigned int newBeginPos = this->absoluteBeginPos(neuronId);
-
-					const unsigned int length = endPos - beginPos;
-					if (length < maxNumberOfSpikes) {
-						for (unsigned int i = 0; i < length; ++i) {
-							this->pastAndNearFutureSpikes_[newBeginPos + i] = this->pastAndNearFutureSpikes_[beginPos + i];
-						}
-						this->pastAndNearFutureSpikesStartEndPos_[neuronId] = std::make_tuple(newBeginPos, newBeginPos + length);
-					} else {
-						std::cout << "spike::v3::IncommingSpikeQueue::addToPast: too many spikes" << std::endl;
-						this->pastAndNearFutureSpikesStartEndPos_[neuronId] = std::make_tuple(newBeginPos, newBeginPos);
-					}
-					tuple = this->pastAndNearFutureSpikesStartEndPos_[neuronId];
-				}
-				this->pastAndNearFutureSpikes_[endPos] = spike;
-				endPos++;
+				this->expire(neuronId);
+				this->pastAndNearFutureSpikes_.add(neuronId, spike);
 			}
 
 			void substractTime(const KernelTime time)
 			{
-				for (const NeuronId neuronId : Topology::iterator_AllNeurons()) {
+				this->pastAndNearFutureSpikes_.substractTime(time);
 
-					const auto tuple = this->pastAndNearFutureSpikesStartEndPos_[neuronId];
-					for (size_t i = std::get<0>(tuple); i < std::get<1>(tuple); ++i) {
-						this->pastAndNearFutureSpikes_[i].kerneltime -= time;
-					}
+				for (IncommingSpike& spike : this->farFutureSpikes_) {
+					spike.kerneltime -= time;
 				}
-
-				for (size_t i = 0; i < this->farFutureSpikesLength_; ++i) {
-					this->farFutureSpikes_[i].kerneltime -= time;
+				for (IncommingSpike& spike : this->nearFutureSpikes_) {
+					spike.kerneltime -= time;
 				}
-				for (size_t i = 0; i < this->nearFutureSpikesLength_; ++i) {
-					this->nearFutureSpikes_[i].kerneltime -= time;
-				}
-
 				this->currentTime_ -= time;
+				this->timeHorizon_ -= time;
+				if (this->nextFarFutureTime_ != LAST_KERNEL_TIME) this->nextFarFutureTime_ -= time;
 			}
 
-		private:
-
-			static const size_t maxNumberOfSpikes = 10000;
-
-			std::vector<IncommingSpike> pastAndNearFutureSpikes_;
-			std::array<std::tuple<unsigned int, unsigned int>, Options::nNeurons> pastAndNearFutureSpikesStartEndPos_;
-
-			// solely for temporary purposes
-			std::vector<IncommingSpike> spikesTmp_;
-
-			//std::priority_queue<IncommingSpike, std::vector<IncommingSpike>, CompareIncommingSpike> spikesQueue_;
-			std::vector<IncommingSpike> farFutureSpikes_;
-			size_t farFutureSpikesLength_;
-
-			std::vector<IncommingSpike> nearFutureSpikes_;
-			size_t nearFutureSpikesLength_;
+			// return the time of the earliest spike that has not been delivered, LAST_KERNEL_TIME if there is none
+			KernelTime getNextSpikeTime() const
+			{
+				return this->nextFarFutureTime_;
+			}
 
-			KernelTime currentTime_; //currentTime_ is only used for debug purposes
+			// return the time up to which the spikes have been delivered: the start of the next window
+			KernelTime getCurrentTime() const
+			{
+				return this->currentTime_;
+			}
 
-			size_t index(const NeuronId neuronId, const size_t pos)
+			// return the time the records of the past and near future spikes of the provided neuron are relative to
+			KernelTime getBaseTime(const NeuronId neuronId) const
 			{
-				return (neuronId * Options::nNeurons) + pos;
+				return this->pastAndNearFutureSpikes_.getBaseTime(neuronId);
 			}
 
-			unsigned int absoluteBeginPos(const NeuronId neuronId) const
+			// return the sum of the positive efficacies of the past and near future spikes of the provided neuron
+			double getPositiveEfficacySum(const NeuronId neuronId) const
 			{
-				return (neuronId * maxNumberOfSpikes);
+				this->expire(neuronId);
+				return this->pastAndNearFutureSpikes_.getPositiveEfficacySum(neuronId);
 			}
-			unsigned int absoluteEndPos(const NeuronId neuronId) const
+
+			// return the number of bytes allocated
+			size_t getMemoryUsage() const
 			{
-				return (neuronId * maxNumberOfSpikes) + Options::nNeurons;
+				return this->pastAndNearFutureSpikes_.getMemoryUsage()
+					+ (this->farFutureSpikes_.capacity() * sizeof(IncommingSpike))
+					+ (this->nearFutureSpikes_.capacity() * sizeof(IncommingSpike));
 			}
 
-			void cleanupPast(const KernelTime kerneltime)
+		private:
+
+			// mutable: the spikes older than timeHorizon_ are removed when a neuron is read, instead of scanning all neurons each window;
+			// concurrent reads are allowed for different neurons only
+			mutable IncommingSpikeStore<Topology, SpikeRecord> pastAndNearFutureSpikes_;
+
+			//std::priority_queue<IncommingSpike, std::vector<IncommingSpike>, CompareIncommingSpike> spikesQueue_;
+			std::vector<IncommingSpike> farFutureSpikes_;
+			std::vector<IncommingSpike> nearFutureSpikes_;
+
+			KernelTime currentTime_;
+			KernelTime timeHorizon_; // the spikes at or before this time are expired
+			KernelTime nextFarFutureTime_; // the earliest time of the far future spikes
+
+			// remove the spikes of the provided neuron that are at or before the time horizon; the epsilon kernel is zero for them
+			void expire(const NeuronId neuronId) const
 			{
-				const KernelTime timeHorizon = kerneltime - Options::toKernelTime(Options::kernelRangeEpsilonInMs);
-				for (const NeuronId neuronId : Topology::iterator_AllNeurons()) {
-					std::tuple<unsigned int, unsigned int>& tuple = this->pastAndNearFutureSpikesStartEndPos_[neuronId];
-					size_t startPos = std::get<0>(tuple);
-					const size_t endPos = std::get<1>(tuple);
-
-					while (startPos < endPos) {
-						if (this->pastAndNearFutureSpikes_[startPos].kerneltime <= timeHorizon) {
-							startPos++;
-						} else {
-							break;
-						}
-					}
-					//if (startPos != std::get<0>(this->pastAndNearFutureSpikesStartEndPos_Exc_[neuronId])) {
-					//	std::cout << "spike::v3::IncommingSpikeQueue: cleanupPast: new startPos=" << startPos << "; old startPos=" << std::get<0>(this->pastAndNearFutureSpikesStartEndPos_Exc_[neuronId]) << std::endl;
-					//}
-					std::get<0>(tuple) = static_cast<unsigned int>(startPos);
-
-					/*
-					000000013FBA2578  cmp         r8,r10
-					000000013FBA257B  jae         labelEND
-					000000013FBA257D  mov         eax,r8d
-					000000013FBA2580  shl         rax,4
-					000000013FBA2584  add         rax,qword ptr [rbx]
-					labelLOOP:
-					000000013FBA2587  cmp         dword ptr [rax],r9d
-					000000013FBA258A  jg          labelEND
-					000000013FBA258C  inc         r8
-					000000013FBA258F  add         rax,10h
-					000000013FBA2593  cmp         r8,r10
-					000000013FBA2596  jb          labelLOOP
-					labelEND:
-					000000013FBA2598  mov         dword ptr [r11+4],r8d
-					*/
-				}
+				this->pastAndNearFutureSpikes_.removeBefore(neuronId, this->timeHorizon_);
 			}
 		};
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,204 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <tuple>
+
+#include "SpikeOptionsStatic.hpp"
+#include "Types.hpp"
+#include "NeuronStateBlocks.hpp"
+#include "TimingWheel.hpp"
+#include "IncommingSpikeStore.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// Alternative for IncommingSpikeQueue with the same interface. The far future spikes are kept in a timing wheel
+		// with one slot per kernel time: scheduling a spike is O(1), advancing the time only touches the slots that
+		// become due. Spikes are delivered to the destinations in order of arrival time.
+		template <typename Topology_i, typename SpikeRecord_i = IncommingSpike>
+		class IncommingSpikeQueueCalendar
+		{
+		public:
+
+			using Topology = Topology_i;
+			using Options = typename Topology_i::Options;
+			using SpikeRecord = SpikeRecord_i; // record of the past and near future spikes, IncommingSpike or PackedIncommingSpike
+
+			// constructor
+			IncommingSpikeQueueCalendar()
+				: farFutureSpikes_(TimingWheel<IncommingSpike>(nSlots))
+				, nearFutureSpikes_(std::vector<IncommingSpike>())
+				, currentTime_(0)
+				, timeHorizon_(-Options::toKernelTime(Options::kernelRangeEpsilonInMs))
+			{
+			}
+
+			// remove all spikes and go back to time zero, the allocated memory is retained
+			void clear()
+			{
+				this->pastAndNearFutureSpikes_.clear();
+				this->farFutureSpikes_.clear();
+				this->nearFutureSpikes_.clear();
+				this->currentTime_ = 0;
+				this->timeHorizon_ = -Options::toKernelTime(Options::kernelRangeEpsilonInMs);
+			}
+
+			void sheduleIncommingSpike(const KernelTime kerneltime, const NeuronId origin, const NeuronId destination, const Efficacy efficacy)
+			{
+				::tools::assert::assert_msg(kerneltime != NO_KERNEL_TIME, "not allowed to shedule NO_KERNEL_TIME");
+				::tools::assert::assert_msg(kerneltime >= this->currentTime_, "spike::v3::IncommingSpikeQueueCalendar::sheduleIncommingSpike: spike time ", kerneltime, " is before current time ", this->currentTime_);
+				::tools::assert::assert_msg((kerneltime - this->currentTime_) < static_cast<KernelTime>(this->farFutureSpikes_.getNumberOfSlots()), "spike::v3::IncommingSpikeQueueCalendar::sheduleIncommingSpike: spike time ", kerneltime, " is too far in the future; currentTime ", this->currentTime_);
+				this->farFutureSpikes_.add(kerneltime, IncommingSpike(kerneltime, origin, destination, efficacy));
+			}
+
+			const std::tuple<const SpikeRecord * const, unsigned int, unsigned int> getPastAndNearFutureSpikes(const NeuronId neuronId) const
+			{
+				this->expire(neuronId);
+				return this->pastAndNearFutureSpikes_.getSpikes(neuronId);
+			}
+
+			void cleanup(const NeuronId neuronId)
+			{
+				this->pastAndNearFutureSpikes_.clear(neuronId);
+			}
+
+			// return the near spikes that have been added by advancing the time
+			const std::tuple<const IncommingSpike * const, size_t, size_t> advanceCurrentTime(
+				const KernelTime futureTime,
+				const NeuronStateBlocks<Topology>& neuronState)
+			{
+				if (Options::tranceNeuronOn)
+				{
+					printf("spike::v3::IncommingSpikeQueueCalendar::advanceCurrentTime: currentTime %5u; advancing time to %5u\n", this->currentTime_, futureTime);
+				}
+				this->timeHorizon_ = futureTime - Options::toKernelTime(Options::kernelRangeEpsilonInMs); // the past spikes are expired when a neuron is touched
+
+				this->nearFutureSpikes_.clear();
+				for (KernelTime t = this->currentTime_; t < futureTime; ++t)
+				{
+					if (this->farFutureSpikes_.empty()) break;
+
+					for (const IncommingSpike& spike : this->farFutureSpikes_.getSlot(t))
+					{
+						this->nearFutureSpikes_.push_back(spike);
+						if (spike.kerneltime >= neuronState.getEndRefractoryPeriod(spike.destination)) // do not add incomming spikes that occur during the refactory period
+						{
+							this->addToPastAndNearFuture(spike.destination, spike);
+						}
+					}
+					this->farFutureSpikes_.clearSlot(t);
+				}
+				this->currentTime_ = futureTime;
+				return std::make_tuple(this->nearFutureSpikes_.data(), 0, this->nearFutureSpikes_.size());
+			}
+
+			void addToPastAndNearFuture(const NeuronId neuronId, const IncommingSpike spike)
+			{
+				if (Options::tranceNeuronOn && (neuronId == Options::tranceNeuron))
+				{
+					printf("spike::v3::IncommingSpikeQueueCalendar::addToPastAndNearFuture: neuronId=%u; spike time %u\n", neuronId, spike.kerneltime);
+				}
+				this->expire(neuronId);
+				this->pastAndNearFutureSpikes_.add(neuronId, spike);
+			}
+
+			void substractTime(const KernelTime time)
+			{
+				this->pastAndNearFutureSpikes_.substractTime(time);
+				for (IncommingSpike& spike : this->nearFutureSpikes_)
+				{
+					spike.kerneltime -= time;
+				}
+
+				// the slot of a spike depends on its time: reschedule all far future spikes
+				const std::vector<IncommingSpike> farFutureSpikes = this->farFutureSpikes_.getAll();
+				this->farFutureSpikes_.clear();
+				for (IncommingSpike spike : farFutureSpikes)
+				{
+					spike.kerneltime -= time;
+					this->farFutureSpikes_.add(spike.kerneltime, spike);
+				}
+				this->currentTime_ -= time;
+				this->timeHorizon_ -= time;
+			}
+
+			// return the time of the earliest spike that has not been delivered, LAST_KERNEL_TIME if there is none
+			KernelTime getNextSpikeTime() const
+			{
+				return this->farFutureSpikes_.getNextOccupiedTime(this->currentTime_);
+			}
+
+			// return the time up to which the spikes have been delivered: the start of the next window
+			KernelTime getCurrentTime() const
+			{
+				return this->currentTime_;
+			}
+
+			// return the time the records of the past and near future spikes of the provided neuron are relative to
+			KernelTime getBaseTime(const NeuronId neuronId) const
+			{
+				return this->pastAndNearFutureSpikes_.getBaseTime(neuronId);
+			}
+
+			// return the sum of the positive efficacies of the past and near future spikes of the provided neuron
+			double getPositiveEfficacySum(const NeuronId neuronId) const
+			{
+				this->expire(neuronId);
+				return this->pastAndNearFutureSpikes_.getPositiveEfficacySum(neuronId);
+			}
+
+			// return the number of bytes allocated
+			size_t getMemoryUsage() const
+			{
+				return this->pastAndNearFutureSpikes_.getMemoryUsage()
+					+ this->farFutureSpikes_.getMemoryUsage()
+					+ (this->nearFutureSpikes_.capacity() * sizeof(IncommingSpike));
+			}
+
+		private:
+
+			// a spike fired in the window [t, t+minDelay] arrives at most maxDelay after the end of the window
+			static const size_t nSlots = static_cast<size_t>(Options::toKernelTime(static_cast<TimeInMs>(Options::maxDelay + Options::minDelay))) + 1;
+
+			// mutable: the spikes older than timeHorizon_ are removed when a neuron is read, instead of scanning all neurons each window;
+			// concurrent reads are allowed for different neurons only
+			mutable IncommingSpikeStore<Topology, SpikeRecord> pastAndNearFutureSpikes_;
+
+			TimingWheel<IncommingSpike> farFutureSpikes_;
+			std::vector<IncommingSpike> nearFutureSpikes_;
+
+			KernelTime currentTime_;
+			KernelTime timeHorizon_; // the spikes at or before this time are expired
+
+			// remove the spikes of the provided neuron that are at or before the time horizon; the epsilon kernel is zero for them
+			void expire(const NeuronId neuronId) const
+			{
+				this->pastAndNearFutureSpikes_.removeBefore(neuronId, this->timeHorizon_);
+			}
+		};
+	}
+}
@@ -0,0 +1,213 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <tuple>
+#include <algorithm>
+
+#include "Types.hpp"
+#include "PackedIncommingSpike.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// Per destination neuron the incomming spikes that have arrived (past) or will arrive in the current window (near future).
+		// Every neuron has its own buffer that grows on demand; spikes that are older than the epsilon kernel are removed from
+		// the front by advancing a begin position, the buffer is compacted when more than half of it consists of removed spikes.
+		// The record of a spike is IncommingSpike or PackedIncommingSpike; the time of a packed record is relative to a base time
+		// per neuron (see getBaseTime), which is moved when a spike does not fit. The stored spikes of a neuron span less than
+		// kernelRangeEpsilonInMs, hence all spikes fit one base time.
+		template <typename Topology_i, typename SpikeRecord_i = IncommingSpike>
+		class IncommingSpikeStore
+		{
+		public:
+
+			using Topology = Topology_i;
+			using Options = typename Topology_i::Options;
+			using SpikeRecord = SpikeRecord_i;
+
+			static_assert(!SpikeRecord::hasBaseTime || (Options::toKernelTime(Options::kernelRangeEpsilonInMs) <= PackedIncommingSpike::maxTimeOffset), "IncommingSpikeStore: the epsilon kernel range does not fit the time of PackedIncommingSpike");
+			static_assert(!SpikeRecord::hasBaseTime || ((Options::nNeurons - 1) <= PackedIncommingSpike::maxOrigin), "IncommingSpikeStore: the number of neurons does not fit the origin of PackedIncommingSpike");
+			static_assert(!SpikeRecord::hasBaseTime || ((Options::maxExcWeight <= PackedIncommingSpike::maxEfficacy) && (-Options::initialWeightInh <= PackedIncommingSpike::maxEfficacy)), "IncommingSpikeStore: the weights do not fit the efficacy of PackedIncommingSpike");
+
+			// constructor
+			IncommingSpikeStore()
+			{
+				this->beginPos_.fill(0);
+				this->baseTime_.fill(0);
+				this->positiveEfficacySum_.fill(0);
+			}
+
+			// return a pointer to the spikes of the provided neuron, and the begin and end position
+			const std::tuple<const SpikeRecord * const, unsigned int, unsigned int> getSpikes(const NeuronId neuronId) const
+			{
+				const std::vector<SpikeRecord>& spikes = this->spikes_[neuronId];
+				return std::make_tuple(spikes.data(), this->beginPos_[neuronId], static_cast<unsigned int>(spikes.size()));
+			}
+
+			// return the time the spike records of the provided neuron are relative to; not used by IncommingSpike
+			KernelTime getBaseTime(const NeuronId neuronId) const
+			{
+				return this->baseTime_[neuronId];
+			}
+
+			// remove the spikes of all neurons, the allocated memory is retained
+			void clear()
+			{
+				for (const NeuronId neuronId : Topology::iterator_AllNeurons())
+				{
+					this->clear(neuronId);
+				}
+				this->baseTime_.fill(0);
+			}
+
+			// remove all spikes of the provided neuron, the allocated memory is retained
+			void clear(const NeuronId neuronId)
+			{
+				this->spikes_[neuronId].clear();
+				this->beginPos_[neuronId] = 0;
+				this->positiveEfficacySum_[neuronId] = 0;
+			}
+
+			void add(const NeuronId neuronId, const IncommingSpike& spike)
+			{
+				std::vector<SpikeRecord>& spikes = this->spikes_[neuronId];
+				unsigned int& beginPos = this->beginPos_[neuronId];
+
+				if ((beginPos > 0) && (spikes.size() == spikes.capacity()) && ((2 * beginPos) >= spikes.size()))
+				{	// instead of growing the buffer, remove the spikes that are no longer used
+					spikes.erase(spikes.begin(), spikes.begin() + beginPos);
+					beginPos = 0;
+				}
+				if (SpikeRecord::hasBaseTime)
+				{
+					this->fitBaseTime(neuronId, spike.kerneltime);
+				}
+				SpikeRecord record;
+				encodeSpikeRecord(spike, this->baseTime_[neuronId], record);
+				spikes.push_back(record);
+				if (record.getEfficacy() > 0)
+				{
+					this->positiveEfficacySum_[neuronId] += record.getEfficacy();
+				}
+			}
+
+			// remove the spikes of the provided neuron that arrived at or before the provided time horizon
+			void removeBefore(const NeuronId neuronId, const KernelTime timeHorizon)
+			{
+				const std::vector<SpikeRecord>& spikes = this->spikes_[neuronId];
+				const unsigned int endPos = static_cast<unsigned int>(spikes.size());
+				const KernelTime baseTime = this->baseTime_[neuronId];
+				unsigned int beginPos = this->beginPos_[neuronId];
+				double positiveEfficacySum = this->positiveEfficacySum_[neuronId];
+
+				while ((beginPos < endPos) && (spikes[beginPos].getKernelTime(baseTime) <= timeHorizon))
+				{
+					if (spikes[beginPos].getEfficacy() > 0)
+					{
+						positiveEfficacySum -= spikes[beginPos].getEfficacy();
+					}
+					beginPos++;
+				}
+				if (beginPos == endPos)
+				{
+					this->clear(neuronId);
+				}
+				else
+				{
+					this->beginPos_[neuronId] = beginPos;
+					this->positiveEfficacySum_[neuronId] = std::max(0.0, positiveEfficacySum);
+				}
+			}
+
+			void substractTime(const KernelTime time)
+			{
+				for (const NeuronId neuronId : Topology::iterator_AllNeurons())
+				{
+					this->baseTime_[neuronId] -= time;
+					std::vector<SpikeRecord>& spikes = this->spikes_[neuronId];
+					for (size_t i = this->beginPos_[neuronId]; i < spikes.size(); ++i)
+					{
+						substractTimeSpikeRecord(spikes[i], time);
+					}
+				}
+			}
+
+			// return the sum of the positive efficacies of the spikes of the provided neuron; maintained when spikes are added and removed
+			double getPositiveEfficacySum(const NeuronId neuronId) const
+			{
+				return this->positiveEfficacySum_[neuronId];
+			}
+
+			// return the number of bytes allocated
+			size_t getMemoryUsage() const
+			{
+				size_t result = sizeof(IncommingSpikeStore);
+				for (const std::vector<SpikeRecord>& spikes : this->spikes_)
+				{
+					result += spikes.capacity() * sizeof(SpikeRecord);
+				}
+				return result;
+			}
+
+		private:
+
+			std::array<std::vector<SpikeRecord>, Options::nNeurons> spikes_;
+			std::array<unsigned int, Options::nNeurons> beginPos_;
+			std::array<KernelTime, Options::nNeurons> baseTime_; // only used by records with a base time
+			std::array<double, Options::nNeurons> positiveEfficacySum_; // double such that subtracting removed spikes does not accumulate rounding errors
+
+			// make sure the provided time fits the base time of the provided neuron, if not, move the base time to the earliest
+			// spike and rebase the stored spikes
+			void fitBaseTime(const NeuronId neuronId, const KernelTime kerneltime)
+			{
+				std::vector<SpikeRecord>& spikes = this->spikes_[neuronId];
+				const unsigned int beginPos = this->beginPos_[neuronId];
+				const KernelTime baseTime = this->baseTime_[neuronId];
+
+				if (beginPos == spikes.size())
+				{
+					this->baseTime_[neuronId] = kerneltime;
+					return;
+				}
+				if ((kerneltime >= baseTime) && ((kerneltime - baseTime) <= PackedIncommingSpike::maxTimeOffset))
+				{
+					return;
+				}
+				KernelTime newBaseTime = kerneltime;
+				for (size_t i = beginPos; i < spikes.size(); ++i)
+				{
+					newBaseTime = std::min(newBaseTime, spikes[i].getKernelTime(baseTime));
+				}
+				for (size_t i = beginPos; i < spikes.size(); ++i)
+				{
+					rebaseSpikeRecord(spikes[i], baseTime, newBaseTime);
+				}
+				this->baseTime_[neuronId] = newBaseTime;
+			}
+		};
+	}
+}
@@ -0,0 +1,295 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>		// std::cout, std::cerr
+#include <thread>
+#include <atomic>
+#include <limits>		// std::numeric_limits
+#include <algorithm>	// std::sort
+#include <cmath>		// std::lroundf
+
+#include "../../Spike-Tools-LIB/SpikeTypes.hpp"
+#include "../../Spike-Tools-LIB/SpikeRuntimeOptions.hpp"
+#include "../../Spike-Tools-LIB/SpscQueue.hpp"
+#include "../../Spike-Tools-LIB/file.ipp"
+#include "../../Spike-Tools-LIB/random.ipp"
+
+#include "Types.hpp"
+#include "SpikeOptionsStatic.hpp"
+#include "SpikeCaseSource.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// Online source of MNIST cases: a producer thread reads the IDX image and label files, encodes the pixels into spike times
+		// and keeps up to lookAhead encoded cases in a bounded SPSC queue, from which SpikeStreamDataSet takes the next case, see
+		// SpikeStreamDataSet::setCaseSource. Replaces the offline DataSetMnist -> Translations -> SpikeDataSet file pipeline; the
+		// files are read in order and rewound at the end, such that training can start before the data set has been read.
+		template <typename Options_i>
+		class MnistSpikeSource : public SpikeCaseSource
+		{
+		public:
+
+			using Options = Options_i;
+
+			// constructor
+			MnistSpikeSource(
+				const std::string& imagesFilename,
+				const std::string& labelsFilename,
+				const ::spike::tools::SpikeRuntimeOptions& spikeRuntimeOptions,
+				const SpikeEncoding spikeEncoding,
+				const unsigned int maxSpikesPerPixel,
+				const size_t lookAhead
+			)
+				: imagesFileStream_(imagesFilename, std::ios::binary)
+				, labelsFileStream_(labelsFilename, std::ios::binary)
+				, caseDurationInMs_(static_cast<TimeInMsI>(spikeRuntimeOptions.getCaseDurationInMs()))
+				, spikeEncoding_(spikeEncoding)
+				, maxSpikesPerPixel_(maxSpikesPerPixel)
+				, queue_(lookAhead)
+				, stop_(false)
+				, producerDone_(false)
+				, nConsumerWaits_(0)
+			{
+				if (spikeRuntimeOptions.getCaseDurationInMs() <= 0)
+				{
+					std::cerr << "spike::v3::MnistSpikeSource: case duration " << spikeRuntimeOptions.getCaseDurationInMs() << " ms is too small; the pixels are encoded into spike times within the case duration" << std::endl;
+					throw std::runtime_error("case duration is too small");
+				}
+				if (!this->imagesFileStream_.is_open())
+				{
+					std::cerr << "spike::v3::MnistSpikeSource: Unable to open file " << imagesFilename << std::endl;
+					throw std::runtime_error("unable to open file");
+				}
+				if (!this->labelsFileStream_.is_open())
+				{
+					std::cerr << "spike::v3::MnistSpikeSource: Unable to open file " << labelsFilename << std::endl;
+					throw std::runtime_error("unable to open file");
+				}
+
+				//1] read the IDX headers: big endian magic number, number of items and for images the number of rows and columns
+				const unsigned int magicNumber1 = this->readInt(this->imagesFileStream_);
+				const unsigned int nImages = this->readInt(this->imagesFileStream_);
+				const unsigned int nRows = this->readInt(this->imagesFileStream_);
+				const unsigned int nCols = this->readInt(this->imagesFileStream_);
+				const unsigned int magicNumber2 = this->readInt(this->labelsFileStream_);
+				const unsigned int nLabels = this->readInt(this->labelsFileStream_);
+				std::cout << "spike::v3::MnistSpikeSource: " << nImages << " images of " << nRows << "x" << nCols << " pixels; " << nLabels << " labels" << std::endl;
+
+				if ((magicNumber1 != 2051) || (magicNumber2 != 2049))
+				{
+					std::cerr << "spike::v3::MnistSpikeSource: unexpected magic numbers " << magicNumber1 << " and " << magicNumber2 << "; expected an IDX image file (2051) and an IDX label file (2049)" << std::endl;
+					throw std::runtime_error("unexpected magic number");
+				}
+				if (nImages != nLabels)
+				{
+					throw std::runtime_error("unequal number of images");
+				}
+				if (nImages > std::numeric_limits<CaseIdType>::max())
+				{
+					throw std::runtime_error("too many images for CaseId");
+				}
+				this->nCases_ = nImages;
+				this->nPixels_ = nRows * nCols;
+
+				//2] the random time of each pixel, drawn once as in TranslationsFactory::createMnistTranslations
+				this->randTime_.resize(this->nPixels_);
+				for (unsigned int pixel = 0; pixel < this->nPixels_; ++pixel)
+				{
+					this->randTime_[pixel] = ::tools::random::rand_int32(this->caseDurationInMs_);
+				}
+			}
+
+			// destructor
+			~MnistSpikeSource() override
+			{
+				this->stop_ = true;
+				if (this->producer_.joinable())
+				{
+					this->producer_.join();
+				}
+				std::cout << "spike::v3::MnistSpikeSource: the consumer waited " << this->nConsumerWaits_ << " times for the producer" << std::endl;
+			}
+
+			MnistSpikeSource(const MnistSpikeSource&) = delete;
+			MnistSpikeSource& operator=(const MnistSpikeSource&) = delete;
+
+			// start the producer thread; subsequent calls have no effect
+			void start() override
+			{
+				if (!this->producer_.joinable())
+				{
+					this->producer_ = std::thread(&MnistSpikeSource::produce, this);
+				}
+			}
+
+			// consumer: move the next encoded case into the provided case, wait for the producer when none is ready;
+			// return false when the producer has stopped
+			bool next(EncodedCase& encodedCase) override
+			{
+				while (!this->queue_.tryPop(encodedCase))
+				{
+					if (this->producerDone_.load(std::memory_order_acquire) && !this->queue_.tryPop(encodedCase))
+					{
+						return false;
+					}
+					this->nConsumerWaits_++;
+					std::this_thread::yield();
+				}
+				return true;
+			}
+
+			size_t getNumberOfCases() const
+			{
+				return this->nCases_;
+			}
+
+			size_t getNumberOfPixels() const
+			{
+				return this->nPixels_;
+			}
+
+			TimeInMs getCaseDurationInMs() const override
+			{
+				return static_cast<TimeInMs>(this->caseDurationInMs_);
+			}
+
+		private:
+
+			// position of the first image and label after the IDX headers
+			static const std::streamoff imagesHeaderSize = 16;
+			static const std::streamoff labelsHeaderSize = 8;
+
+			std::ifstream imagesFileStream_; // only read by the producer after construction
+			std::ifstream labelsFileStream_;
+
+			size_t nCases_;
+			unsigned int nPixels_;
+			const TimeInMsI caseDurationInMs_;
+			const SpikeEncoding spikeEncoding_;
+			const unsigned int maxSpikesPerPixel_; // used by SpikeEncoding::RATE
+			std::vector<TimeInMsI> randTime_; // per pixel
+
+			::spike::tools::SpscQueue<EncodedCase> queue_;
+			std::thread producer_;
+			std::atomic<bool> stop_;
+			std::atomic<bool> producerDone_;
+			size_t nConsumerWaits_; // only used by the consumer
+
+			unsigned int readInt(std::ifstream& inputFileStream)
+			{
+				unsigned int i = 0;
+				inputFileStream.read(reinterpret_cast<char*>(&i), sizeof(i));
+				return ::tools::file::reverseInt(i);
+			}
+
+			void produce()
+			{
+				std::vector<unsigned char> pixels(this->nPixels_);
+				size_t caseIndex = 0;
+				EncodedCase encodedCase;
+
+				while (!this->stop_.load(std::memory_order_relaxed))
+				{
+					if (caseIndex == this->nCases_)
+					{	// next epoch: rewind
+						caseIndex = 0;
+						this->imagesFileStream_.clear();
+						this->imagesFileStream_.seekg(imagesHeaderSize);
+						this->labelsFileStream_.clear();
+						this->labelsFileStream_.seekg(labelsHeaderSize);
+					}
+					unsigned char label = 0;
+					this->imagesFileStream_.read(reinterpret_cast<char*>(pixels.data()), pixels.size());
+					this->labelsFileStream_.read(reinterpret_cast<char*>(&label), sizeof(label));
+					if (!this->imagesFileStream_ || !this->labelsFileStream_)
+					{
+						std::cerr << "spike::v3::MnistSpikeSource::produce: could not read case " << caseIndex << std::endl;
+						break;
+					}
+
+					encodedCase.caseId = CaseId(static_cast<CaseIdType>(caseIndex));
+					encodedCase.caseLabel = CaseLabel(static_cast<CaseLabelType>(label));
+					encodedCase.events.clear();
+					for (unsigned int pixel = 0; pixel < this->nPixels_; ++pixel)
+					{
+						this->encode(pixel, pixels[pixel], encodedCase.events);
+					}
+					caseIndex++;
+
+					while (!this->queue_.tryPush(encodedCase))
+					{
+						if (this->stop_.load(std::memory_order_relaxed)) break;
+						std::this_thread::yield();
+					}
+				}
+				this->producerDone_.store(true, std::memory_order_release);
+			}
+
+			// append the spikes of the provided pixel, in time order
+			void encode(const unsigned int pixel, const unsigned char value, std::vector<SensorEvent>& events) const
+			{
+				const TimeInMsI durationInMs = this->caseDurationInMs_;
+				const size_t begin = events.size();
+				switch (this->spikeEncoding_)
+				{
+					case SpikeEncoding::THRESHOLD:
+						if (value >= 170)
+						{
+							events.push_back(SensorEvent(Options::toKernelTime(static_cast<TimeInMs>(this->randTime_[pixel])), pixel));
+						}
+						break;
+					case SpikeEncoding::RATE:
+					{
+						// the spike times of TranslationsFactory::createMnistSpikeSet with nSpikes proportional to the intensity
+						const unsigned int nSpikes = static_cast<unsigned int>(std::lroundf((value * this->maxSpikesPerPixel_) / 255.0f));
+						if (nSpikes > 0)
+						{
+							const float timeBetweenSpikes = static_cast<float>(durationInMs) / nSpikes;
+							const float shiftBetweenTranslations = timeBetweenSpikes / nSpikes;
+							for (unsigned int i = 0; i < nSpikes; ++i)
+							{
+								const TimeInMsI timeInMs = (this->randTime_[pixel] + static_cast<TimeInMsI>(std::lroundf((i * timeBetweenSpikes) + shiftBetweenTranslations))) % durationInMs;
+								events.push_back(SensorEvent(Options::toKernelTime(static_cast<TimeInMs>(timeInMs)), pixel));
+							}
+						}
+						break;
+					}
+					case SpikeEncoding::LATENCY:
+						if (value > 0)
+						{
+							const TimeInMs timeInMs = (static_cast<TimeInMs>(255 - value) / 255.0f) * static_cast<TimeInMs>(durationInMs - 1);
+							events.push_back(SensorEvent(Options::toKernelTime(timeInMs), pixel));
+						}
+						break;
+				}
+				std::sort(events.begin() + begin, events.end(), [](const SensorEvent& a, const SensorEvent& b) { return a.offset < b.offset; });
+			}
+		};
+	}
+}
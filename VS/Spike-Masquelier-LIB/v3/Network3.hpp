@@ -24,6 +24,7 @@
 
 #include <string>
 #include <vector>
+#include <array>
 #include <memory>
 #include <ratio>
 #include <sstream>		// for std::ostringstream
@@ -31,6 +32,9 @@
 #include <iomanip>      // std::setprecision
 #include <math.h>		// for log2
 #include <limits>		// std::numeric_limits
+#include <chrono>		// std::chrono::steady_clock
+#include <cstring>		// memcpy
+#include <algorithm>	// std::max_element
 
 #include "omp.h"
 
@@ -45,8 +49,15 @@
 #include "SpikeOptionsStatic.hpp"
 #include "Topology.hpp"
 #include "Synapses.hpp"
+#include "SynapsesSparse.hpp"
 #include "IncommingSpikeQueue.hpp"
-#include "SpikeHistory.hpp"
+#include "IncommingSpikeQueueCalendar.hpp"
+#include "NeuronStateBlocks.hpp"
+#include "ExponentialVoltageState.hpp"
+#include "NeuronBitSet.hpp"
+#include "RandomSpikeScheduler.hpp"
+#include "AxonalEventQueue.hpp"
+#include "RecentDeliveries.hpp"
 #include "SpikeStreamDataSet.hpp"
 
 namespace spike
@@ -55,11 +66,22 @@ namespace spike
 	{
 		using namespace ::spike::tools;
 
-		template <typename Topology_i, typename SpikeStream_i>
+		// statistics collected per thread, such that the parallel test phase needs no synchronisation
+		struct ThreadStatistics
+		{
+			double maxVoltageDeviation = 0; // max deviation between the selected voltage engine and the exact kernel sum
+			size_t nNeuronTests = 0; // number of neurons tested for firing in the current second
+			size_t nNeuronTestsSkipped = 0; // number of these tests that were decided by the voltage upper bound
+			char padding_[64]; // the statistics of different threads are not in the same cache line
+		};
+
+		template <typename Topology_i, typename SpikeStream_i, typename SpikeQueue_i = IncommingSpikeQueue<Topology_i>, typename Synapses_i = Synapses<Topology_i>>
 		struct State
 		{
 			using Topology = Topology_i;
 			using SpikeStream = SpikeStream_i;
+			using SpikeQueue = SpikeQueue_i;
+			using Synapses = Synapses_i;
 			using Options = typename Topology_i::Options;
 
 			Options options_;
@@ -76,13 +98,21 @@ namespace spike
 			SpikeNetworkPerformance<Topology, TimeInMs> spikeNetworkPerformance_;
 
 			std::shared_ptr<Topology> topology_;
-			Synapses<Topology> synapses_;
+			std::shared_ptr<Synapses> synapses_; // shared between networks with Options::inferenceOnly, see BatchEvaluator
+
+			SpikeQueue incommingSpikes_;
+			AxonalEventQueue<Topology> axonalEvents_; // only used with Options::axonalFanOut
+			KernelTime nextWeightFlushTime_ = 0; // only used with Options::deferWeightUpdates
+			RecentDeliveries<Topology> recentDeliveries_; // only used with PlasticityEngine::RECENT_DELIVERIES
+
+			RandomSpikeScheduler<Topology> randomSpikeScheduler_;
 
-			IncommingSpikeQueue<Topology> incommingSpikes_;
-			std::array<PostSynapticSpike, Options::nNeurons> nextRandomPostSynapticSpike_;
+			// Exc, Inh and Motor neurons that may fire in the current window: neurons with incomming spikes and neurons with a due random spike
+			NeuronBitSet<Options::nNeurons> activeNeurons_;
+			std::vector<NeuronId> neuronsToTest_; // the neurons tested in the current window, in increasing order
 
-			std::array<KernelTime, Options::nNeurons> lastSpikeTime_;
-			SpikeHistory4<Topology> endRefractoryPeriods_;
+			NeuronStateBlocks<Topology> neuronState_; // refractory periods, last spike time and next random spike time
+			ExponentialVoltageState<Topology> voltageState_; // only used with VoltageEngine::EXPONENTIAL_STATE
 
 			std::vector<Voltage> cachedThreshold_;
 			std::vector<Voltage> cachedEpsilon_;
@@ -90,8 +120,23 @@ namespace spike
 			std::vector<float> cachedLtp_;
 			std::vector<float> cachedLtd_;
 
+			// bounds of the kernels for the voltage upper bound
+			Voltage maxEpsilon_;
+			Voltage maxEta_;
+			Voltage minThreshold_;
+
 			size_t nSpikesPropagatedLastSec_; // number of spikes of type propagated in the current second
 			size_t nSpikesRandomLastSec_; // number of spikes of type random in the current second
+			size_t nNeuronsTestedLastSec_; // number of Exc, Inh and Motor neurons tested for firing in the current second
+			size_t nWindowsSkippedLastSec_; // number of windows in the current second in which nothing could happen
+			size_t nSynapticEventsLastSec_; // number of spikes sent over a synapse in the current second
+			size_t nQueueInsertionsLastSec_; // number of events scheduled by fire in the current second: incomming spikes, or axonal events with Options::axonalFanOut
+			std::array<unsigned int, Topology::Nm> motorSpikeCount_; // number of propagated spikes per motor neuron in the current case
+			KernelTime decisionCaseStartTime_ = 0; // start time of the case of motorSpikeCount_, only used with Options::decisionPolicy
+
+			int nThreads_; // number of threads used to test the neurons for firing
+			std::vector<std::vector<PostSynapticSpike>> firingBuffers_; // per thread: the spikes of the neurons that fire in the current window
+			mutable std::vector<ThreadStatistics> threadStatistics_;
 
 			// constructor
 			State() = delete;
@@ -115,8 +160,12 @@ namespace spike
 				, cachedEta_(std::vector<Voltage>(static_cast<size_t>(Options::toKernelTime(static_cast<TimeInMs>(Options::kernelRangeEtaInMs)))))
 				, cachedLtp_(std::vector<float>(static_cast<size_t>(Options::toKernelTime(static_cast<TimeInMs>(Options::kernelRangeStdpInMs)))))
 				, cachedLtd_(std::vector<float>(static_cast<size_t>(Options::toKernelTime(static_cast<TimeInMs>(Options::kernelRangeStdpInMs)))))
+
+				, nThreads_(Options::useOpenMP ? std::min(static_cast<int>(Options::maxNumberOfThreads), omp_get_num_procs()) : 1)
+				, firingBuffers_(std::vector<std::vector<PostSynapticSpike>>(std::max(1, static_cast<int>(Options::maxNumberOfThreads))))
+				, threadStatistics_(std::vector<ThreadStatistics>(std::max(1, static_cast<int>(Options::maxNumberOfThreads))))
 			{
-				this->lastSpikeTime_.fill(Options::toKernelTime(-1000));
+				this->motorSpikeCount_.fill(0);
 				this->initCachedData();
 			}
 
@@ -174,23 +223,36 @@ namespace spike
 				{
 					this->cachedThreshold_[i] = this->cachedThreshold_[i] - lastThreshold + 1.0f;
 				}
+
+				// eta and threshold are zero and one outside their range; the threshold is the product of at most four factors
+				this->maxEpsilon_ = *std::max_element(this->cachedEpsilon_.begin(), this->cachedEpsilon_.end());
+				this->maxEta_ = std::max(0.0f, *std::max_element(this->cachedEta_.begin(), this->cachedEta_.end()));
+				const Voltage minThresholdFactor = std::min(1.0f, *std::min_element(this->cachedThreshold_.begin(), this->cachedThreshold_.end()));
+				this->minThreshold_ = Options::minimalThreshold * minThresholdFactor * minThresholdFactor * minThresholdFactor * minThresholdFactor;
 			}
 		};
 
 
 
-		template <typename Topology_i, typename SpikeStream_i>
+		// SpikeQueue_i is the queue of incomming spikes: IncommingSpikeQueue or IncommingSpikeQueueCalendar
+		// Synapses_i is the synapse store: Synapses (dense) or SynapsesSparse
+		template <typename Topology_i, typename SpikeStream_i, typename SpikeQueue_i = IncommingSpikeQueue<Topology_i>, typename Synapses_i = Synapses<Topology_i>>
 		class Network3
 		{
 		public:
 
 			using Topology = Topology_i;
 			using SpikeStream = SpikeStream_i;
+			using SpikeQueue = SpikeQueue_i;
+			using Synapses = Synapses_i;
 			using Options = typename Topology_i::Options;
+			using SpikeRecord = typename SpikeQueue_i::SpikeRecord;
+
+			static_assert(!Options::inferenceOnly || (!Options::deferWeightUpdates && (Options::plasticityEngine == PlasticityEngine::PAIR_SCAN)), "Network3: inferenceOnly has no weight updates to defer and no plasticity engine");
 
 			// constructor
 			Network3()
-				: state_(State<Topology, SpikeStream>())
+				: state_(State<Topology, SpikeStream, SpikeQueue, Synapses>())
 			{
 			}
 
@@ -199,7 +261,7 @@ namespace spike
 				const Options& options,
 				const SpikeRuntimeOptions& SpikeRuntimeOptions
 			)
-				: state_(State<Topology, SpikeStream>(options, SpikeRuntimeOptions))
+				: state_(State<Topology, SpikeStream, SpikeQueue, Synapses>(options, SpikeRuntimeOptions))
 			{
 			}
 
@@ -212,7 +274,16 @@ namespace spike
 			void setTopology(const std::shared_ptr<Topology>& topology)
 			{
 				this->state_.topology_ = topology;
-				this->state_.synapses_.init(topology);
+				this->state_.synapses_ = std::make_shared<Synapses>();
+				this->state_.synapses_->init(topology);
+			}
+
+			// use synapses that have been initialised with the provided topology; with Options::inferenceOnly the weights are
+			// read-only, hence networks that share their synapses can run concurrently
+			void setTopology(const std::shared_ptr<Topology>& topology, const std::shared_ptr<Synapses>& synapses)
+			{
+				this->state_.topology_ = topology;
+				this->state_.synapses_ = synapses;
 			}
 
 			const std::shared_ptr<const Topology> getTopology() const
@@ -221,6 +292,127 @@ namespace spike
 				return this->state_.topology_;
 			}
 
+			// set the number of threads that test the neurons for firing; the result of the simulation does not depend on the number of threads
+			void setNumberOfThreads(const int nThreads)
+			{
+				this->state_.nThreads_ = std::max(1, nThreads);
+				if (this->state_.firingBuffers_.size() < static_cast<size_t>(this->state_.nThreads_))
+				{
+					this->state_.firingBuffers_.resize(this->state_.nThreads_);
+					this->state_.threadStatistics_.resize(this->state_.nThreads_);
+				}
+			}
+
+			int getNumberOfThreads() const
+			{
+				return this->state_.nThreads_;
+			}
+
+			// hash of the bit patterns of all weights, used to check that different runs yield identical networks
+			unsigned long long getWeightHash() const
+			{
+				unsigned long long hash = 14695981039346656037ULL; // FNV-1a
+				for (const NeuronId origin : Topology::iterator_AllNeurons())
+				{
+					for (const SynapseId synapseId : this->state_.synapses_->getOutgoingSynapses(origin))
+					{
+						const float weight = this->state_.synapses_->getWeight(synapseId);
+						unsigned int bits;
+						memcpy(&bits, &weight, sizeof(bits));
+						hash = (hash ^ bits) * 1099511628211ULL;
+					}
+				}
+				return hash;
+			}
+
+			// return the max deviation between the selected voltage engine and the exact kernel sum, see calcVoltage_Exact; only measured when Options::checkVoltageEngine
+			double getMaxVoltageDeviation() const
+			{
+				double result = 0;
+				for (const ThreadStatistics& statistics : this->state_.threadStatistics_)
+				{
+					result = std::max(result, statistics.maxVoltageDeviation);
+				}
+				return result;
+			}
+
+			// return the fraction of the neuron tests in the current second that were decided by the voltage upper bound
+			double getFractionNeuronTestsSkipped() const
+			{
+				size_t nTests = 0;
+				size_t nSkipped = 0;
+				for (const ThreadStatistics& statistics : this->state_.threadStatistics_)
+				{
+					nTests += statistics.nNeuronTests;
+					nSkipped += statistics.nNeuronTestsSkipped;
+				}
+				return (nTests == 0) ? 0 : (static_cast<double>(nSkipped) / nTests);
+			}
+
+			// print the memory of the queues and the synapses; mainLoop prints it after the run, when the buffers have grown to their working size
+			void printMemoryUsage() const
+			{
+				const double MB = 1024.0 * 1024.0;
+				printf("spike::v3::Network3: memory usage: incomming spikes %.2f MB; axonal events %.2f MB; synapses %.2f MB\n", this->state_.incommingSpikes_.getMemoryUsage() / MB, this->state_.axonalEvents_.getMemoryUsage() / MB, this->state_.synapses_->getMemoryUsage() / MB);
+			}
+
+			// bring the neurons and the queues back to time zero, as in a new network, such that the network can run the next case
+			// with runCase; the synapses, the kernel tables and the allocated memory are retained. The synapses keep the times of
+			// their last deliveries, hence this requires the read-only weights of Options::inferenceOnly.
+			void resetCase()
+			{
+				static_assert(Options::inferenceOnly, "Network3::resetCase: the synapses are not reset, which requires Options::inferenceOnly");
+				State<Topology, SpikeStream, SpikeQueue, Synapses>& state = this->state_;
+				state.incommingSpikes_.clear();
+				state.axonalEvents_.clear();
+				state.randomSpikeScheduler_.clear();
+				state.activeNeurons_.clear();
+				state.neuronsToTest_.clear();
+				state.neuronState_.clear();
+				state.voltageState_.clear();
+				state.motorSpikeCount_.fill(0);
+				state.decisionCaseStartTime_ = 0;
+			}
+
+			// run the network from time zero over the first case of the spike stream, which takes the provided duration, and return the
+			// number of propagated spikes of every motor neuron; used by BatchEvaluator with a network per thread that is reset with
+			// resetCase between the cases. With Options::decisionPolicy the run stops at the end of the window in which the decision
+			// is reached, which is recorded in the case occurance of the stream.
+			std::array<unsigned int, Topology::Nm> runCase(const KernelTime duration)
+			{
+				KernelTime currentTime = 0;
+				const KernelTime minDelay = Options::toKernelTime(static_cast<TimeInMs>(this->state_.options_.minDelay));
+
+				this->state_.motorSpikeCount_.fill(0);
+				for (const NeuronId& neuronId : Topology::iterator_AllNeurons())
+				{
+					Network3::updateNextRandomPostSynapticSpike(this->state_, neuronId, currentTime);
+				}
+				while (currentTime < duration)
+				{
+					const KernelTime nSilentWindows = this->getNumberOfSilentWindows(currentTime, minDelay, (duration - currentTime) / minDelay);
+					if (nSilentWindows > 0)
+					{
+						currentTime += nSilentWindows * minDelay;
+						this->state_.spikeStream_->advanceCurrentTime(nSilentWindows * minDelay);
+						continue;
+					}
+					const KernelTime maxAdvanceTime = currentTime + minDelay;
+					this->advanceTime(maxAdvanceTime);
+					this->findAndFireNeuronA(currentTime, maxAdvanceTime, false, false);
+					currentTime += minDelay;
+					this->state_.spikeStream_->advanceCurrentTime(minDelay);
+
+					const CaseLabel decision = Network3::getDecision(this->state_.motorSpikeCount_);
+					if (decision != NO_CASE_LABEL)
+					{
+						this->state_.spikeStream_->endCurrentCase(decision);
+						break;
+					}
+				}
+				return this->state_.motorSpikeCount_;
+			}
+
 			void mainLoop(const TimeInSec nSeconds, const bool useConfusionMatrix)
 			{
 				KernelTime currentTime = 0;
@@ -237,11 +429,15 @@ namespace spike
 
 				for (TimeInSec sec = 0; sec < nSeconds; ++sec)
 				{
-					const clock_t t1 = clock();
+					const auto t1 = std::chrono::steady_clock::now();
 
 					{	// reset non-essential reporting counters 
 						this->state_.nSpikesPropagatedLastSec_ = 0;
 						this->state_.nSpikesRandomLastSec_ = 0;
+						this->state_.nNeuronsTestedLastSec_ = 0;
+						this->state_.nWindowsSkippedLastSec_ = 0;
+						this->state_.nSynapticEventsLastSec_ = 0;
+						this->state_.nQueueInsertionsLastSec_ = 0;
 					}
 					{	// check for KernelTime overflow
 						if (currentTime > 1000000000)
@@ -266,17 +462,53 @@ namespace spike
 
 					while (currentTimeSubSecond < (Options::toKernelTime(1000)))
 					{
+						const KernelTime nSilentWindows = this->getNumberOfSilentWindows(currentTime, minDelay, (Options::toKernelTime(1000) - currentTimeSubSecond) / minDelay);
+						if (nSilentWindows > 0)
+						{	// jump over the windows in which nothing happens; the queue catches up in the next advanceTime
+							currentTime += nSilentWindows * minDelay;
+							currentTimeSubSecond += nSilentWindows * minDelay;
+							this->state_.spikeStream_->advanceCurrentTime(nSilentWindows * minDelay);
+							this->state_.nWindowsSkippedLastSec_ += nSilentWindows;
+							continue;
+						}
 
 						const KernelTime maxAdvanceTime = currentTime + minDelay;
+						if (Options::decisionPolicy != DecisionPolicy::NONE)
+						{	// the motor spikes are counted per case
+							const KernelTime caseStartTime = this->state_.spikeStream_->getCurrentCaseStartTime();
+							if (caseStartTime != this->state_.decisionCaseStartTime_)
+							{
+								this->state_.motorSpikeCount_.fill(0);
+								this->state_.decisionCaseStartTime_ = caseStartTime;
+							}
+						}
 						this->advanceTime(maxAdvanceTime);
 
 						this->findAndFireNeuronA(currentTime, maxAdvanceTime, dumpSpikes, dumpState);
 						currentTime += minDelay;
 						currentTimeSubSecond += minDelay;
 
+						if (Options::deferWeightUpdates && (currentTime >= this->state_.nextWeightFlushTime_))
+						{
+							this->state_.synapses_->flushWeightDeltas();
+							this->state_.nextWeightFlushTime_ = currentTime + Options::toKernelTime(Options::weightFlushIntervalInMs);
+						}
+
 						this->state_.spikeStream_->advanceCurrentTime(minDelay);
+						if ((Options::decisionPolicy != DecisionPolicy::NONE) && (this->state_.spikeStream_->getCurrentCaseStartTime() == this->state_.decisionCaseStartTime_))
+						{	// the case did not end in this window: end it early when a motor neuron has won
+							const CaseLabel decision = Network3::getDecision(this->state_.motorSpikeCount_);
+							if (decision != NO_CASE_LABEL)
+							{
+								this->state_.spikeStream_->endCurrentCase(decision);
+							}
+						}
 						//std::cout << "spike::v3::Network3::mainLoop: B: currentTimeThisSecond=" << currentTimeThisSecond << "; sec=" << sec << "; currentTime=" << currentTime << "; maxAdvanceTime=" << maxAdvanceTime << std::endl;
 					}
+					if (Options::deferWeightUpdates)
+					{	// the weights are reported and dumped below
+						this->state_.synapses_->flushWeightDeltas();
+					}
 					{
 						{
 							if (dumpSpikes) this->state_.dumperSpikes_.dump(sec, "train", this->state_.spikeSet_, this->state_.spikeStream_->getCaseUsage());
@@ -302,12 +534,49 @@ namespace spike
 							const float wSensor = this->getAverageOutgoingWeightSensor();
 							const float wMotor = this->getAverageIncommingWeightMotor();
 
-							const clock_t t2 = clock();
-							const double diff = static_cast<double>(t2 - t1);
+							const auto t2 = std::chrono::steady_clock::now();
+							const double diff = std::chrono::duration<double, std::milli>(t2 - t1).count();
 							printf("spike::v3::mainloop: time %4u/%u s sim, %5.0f ms wall; nSpikes %5zu prop, %5zu rand; w_out_sensor %5.4f; w_out_exc %5.4f; w_in_motor %5.4f\n", sec, nSeconds, diff, this->state_.nSpikesPropagatedLastSec_, this->state_.nSpikesRandomLastSec_, wSensor, wExc, wMotor);
+							if (Options::checkVoltageEngine)
+							{
+								printf("spike::v3::mainloop: max voltage deviation with exact kernel sum %e\n", this->getMaxVoltageDeviation());
+							}
+							if (Options::printStatistics)
+							{
+								if (Options::useActiveNeuronSet)
+								{
+									const double nWindowsPerSec = 1000.0 / Options::minDelay;
+									printf("spike::v3::mainloop: active neuron set: %.1f of %zu neurons tested per window\n", this->state_.nNeuronsTestedLastSec_ / nWindowsPerSec, Topology::Nm_end - Topology::Ne_start);
+								}
+								printf("spike::v3::mainloop: %zu synaptic events, %.2f M events/s wall\n", this->state_.nSynapticEventsLastSec_, this->state_.nSynapticEventsLastSec_ / (1000 * diff));
+								const size_t nSpikes = this->state_.nSpikesPropagatedLastSec_ + this->state_.nSpikesRandomLastSec_;
+								printf("spike::v3::mainloop: %.1f queue insertions per fired spike (%s fan-out)\n", (nSpikes == 0) ? 0.0 : (static_cast<double>(this->state_.nQueueInsertionsLastSec_) / nSpikes), (Options::axonalFanOut) ? "axonal" : "synaptic");
+								if (Options::skipSilentWindows)
+								{
+									printf("spike::v3::mainloop: skipped %zu of %d silent windows\n", this->state_.nWindowsSkippedLastSec_, static_cast<int>(1000 / Options::minDelay));
+								}
+								if (Options::useVoltageUpperBound)
+								{
+									printf("spike::v3::mainloop: voltage upper bound: skipped %5.1f%% of the neuron tests\n", 100 * this->getFractionNeuronTestsSkipped());
+								}
+							}
+							if (Options::deferWeightUpdates)
+							{
+								printf("spike::v3::mainloop: weight updates deferred, flushed every %.1f ms\n", Options::weightFlushIntervalInMs);
+							}
+							if (Options::inferenceOnly)
+							{
+								printf("spike::v3::mainloop: inference only, weights frozen\n");
+							}
+							for (ThreadStatistics& statistics : this->state_.threadStatistics_)
+							{
+								statistics.nNeuronTests = 0;
+								statistics.nNeuronTestsSkipped = 0;
+							}
 						}
 					}
 				}
+				this->printMemoryUsage();
 			}
 
 			void printKernels(const std::string& filename) const
@@ -345,11 +614,11 @@ namespace spike
 
 		private:
 
-			State<Topology, SpikeStream> state_;
+			State<Topology, SpikeStream, SpikeQueue, Synapses> state_;
 
-			Voltage static calcVoltage(const State<Topology, SpikeStream>& state, const NeuronId neuronId, const KernelTime kerneltime)
+			Voltage static calcVoltage(const State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const NeuronId neuronId, const KernelTime kerneltime)
 			{
-				KernelTime endRefractoryPeriod = std::get<0>(state.endRefractoryPeriods_.getSpikes(neuronId));
+				KernelTime endRefractoryPeriod = state.neuronState_.getEndRefractoryPeriod(neuronId);
 				KernelTime timeSinceLastRefreactoryPeriod = kerneltime - endRefractoryPeriod;
 
 				//std::cout << "spike::v3::Network3::calcVoltage: neuronId=" << neuronId << "; kerneltime=" << kerneltime << "; endRefractoryPeriod=" << endRefractoryPeriod << "; timeSinceLastRefreactoryPeriod = " << timeSinceLastRefreactoryPeriod << std::endl;
@@ -358,10 +627,59 @@ namespace spike
 				{
 					return Options::minVoltage;
 				}
-				Voltage voltage = (timeSinceLastRefreactoryPeriod < Options::toKernelTime(Options::kernelRangeEtaInMs)) ? state.cachedEta_[timeSinceLastRefreactoryPeriod] : 0;
+				const Voltage eta = (timeSinceLastRefreactoryPeriod < Options::toKernelTime(Options::kernelRangeEtaInMs)) ? state.cachedEta_[timeSinceLastRefreactoryPeriod] : 0;
+
+				if (Options::checkVoltageEngine)
+				{
+					const Voltage epsilon = (Options::voltageEngine == VoltageEngine::EXPONENTIAL_STATE)
+						? state.voltageState_.getVoltage(neuronId, state.incommingSpikes_.getPastAndNearFutureSpikes(neuronId), state.incommingSpikes_.getBaseTime(neuronId), kerneltime)
+						: Network3::calcVoltage_TableSum(state, neuronId, kerneltime, 0);
+					const double deviation = std::abs(static_cast<double>(epsilon) - Network3::calcVoltage_Exact(state, neuronId, kerneltime));
+					ThreadStatistics& statistics = state.threadStatistics_[Network3::getThreadId(state)];
+					if (deviation > statistics.maxVoltageDeviation)
+					{
+						statistics.maxVoltageDeviation = deviation;
+					}
+					return eta + epsilon;
+				}
+				if (Options::voltageEngine == VoltageEngine::EXPONENTIAL_STATE)
+				{
+					return eta + state.voltageState_.getVoltage(neuronId, state.incommingSpikes_.getPastAndNearFutureSpikes(neuronId), state.incommingSpikes_.getBaseTime(neuronId), kerneltime);
+				}
+				else
+				{
+					return Network3::calcVoltage_TableSum(state, neuronId, kerneltime, eta);
+				}
+			}
+
+			// return the untruncated epsilon kernel summed over all incomming spikes in the queue, also the past spikes after
+			// a spike in the future; the reference of Options::checkVoltageEngine. Spikes older than kernelRangeEpsilonInMs
+			// may have expired from the queue, their contribution is below epsilon(kernelRangeEpsilonInMs) each.
+			double static calcVoltage_Exact(const State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const NeuronId neuronId, const KernelTime kerneltime)
+			{
+				double voltage = 0;
+				const std::tuple<const SpikeRecord * const, unsigned int, unsigned int> tuple = state.incommingSpikes_.getPastAndNearFutureSpikes(neuronId);
+				const SpikeRecord * const incommingSpikes = std::get<0>(tuple);
+				const KernelTime baseTime = state.incommingSpikes_.getBaseTime(neuronId);
+				for (unsigned int i = std::get<1>(tuple); i < std::get<2>(tuple); ++i)
+				{
+					const KernelTime incommingTimeRelative = kerneltime - incommingSpikes[i].getKernelTime(baseTime);
+					if (incommingTimeRelative > 0)
+					{
+						voltage += static_cast<double>(incommingSpikes[i].getEfficacy()) * state.options_.epsilon_f(Options::toTimeInMs(incommingTimeRelative));
+					}
+				}
+				return voltage;
+			}
+
+			// return the provided voltage plus the cached epsilon kernel summed over all incomming spikes
+			Voltage static calcVoltage_TableSum(const State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const NeuronId neuronId, const KernelTime kerneltime, const Voltage initialVoltage)
+			{
+				Voltage voltage = initialVoltage;
 
-				std::tuple<const IncommingSpike * const, unsigned int, unsigned int> tuple = state.incommingSpikes_.getPastAndNearFutureSpikes(neuronId);
-				const IncommingSpike * const incommingSpikes = std::get<0>(tuple);
+				std::tuple<const SpikeRecord * const, unsigned int, unsigned int> tuple = state.incommingSpikes_.getPastAndNearFutureSpikes(neuronId);
+				const SpikeRecord * const incommingSpikes = std::get<0>(tuple);
+				const KernelTime baseTime = state.incommingSpikes_.getBaseTime(neuronId);
 				const size_t startPos = std::get<1>(tuple);
 				const size_t endPos = std::get<2>(tuple);
 
@@ -372,20 +690,21 @@ namespace spike
 
 				for (size_t i = startPos; i < endPos; ++i)
 				{
-					const IncommingSpike& incommingSpike = incommingSpikes[i];
-					const KernelTime incommingTimeRelative = kerneltime - incommingSpike.kerneltime;
+					const SpikeRecord& incommingSpike = incommingSpikes[i];
+					const KernelTime incommingTime = incommingSpike.getKernelTime(baseTime);
+					const KernelTime incommingTimeRelative = kerneltime - incommingTime;
 
 					if (incommingTimeRelative >= 0)
 					{
 						if (incommingTimeRelative < Options::toKernelTime(Options::kernelRangeEpsilonInMs))
 						{
 							const Voltage epsilon = state.cachedEpsilon_[incommingTimeRelative];
-							const Voltage delta = incommingSpike.efficacy * epsilon;
+							const Voltage delta = incommingSpike.getEfficacy() * epsilon;
 							voltage += delta;
 
 							if (false && Options::tranceNeuronOn && (neuronId == Options::tranceNeuron))
 							{
-								printf("spike::v3::Network3::calcVoltage: B: neuronId=%4u; kerneltime=%5u; incommingTime=%5u; origin=%4u; epsilon=%f; delta=%f; voltage=%f\n", neuronId, kerneltime, incommingSpike.kerneltime, incommingSpike.origin, epsilon, delta, voltage);
+								printf("spike::v3::Network3::calcVoltage: B: neuronId=%4u; kerneltime=%5u; incommingTime=%5u; origin=%4u; epsilon=%f; delta=%f; voltage=%f\n", neuronId, kerneltime, incommingTime, incommingSpike.getOrigin(), epsilon, delta, voltage);
 							}
 						}
 					}
@@ -399,10 +718,10 @@ namespace spike
 				return voltage;
 			}
 
-			Voltage static calcThreshold(const State<Topology, SpikeStream>& state, const NeuronId neuronId, const KernelTime kerneltime)
+			Voltage static calcThreshold(const State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const NeuronId neuronId, const KernelTime kerneltime)
 			{
 				Voltage threshold = Options::minimalThreshold;
-				const std::tuple<KernelTime, KernelTime, KernelTime, KernelTime> tuple = state.endRefractoryPeriods_.getSpikes(neuronId);
+				const std::tuple<KernelTime, KernelTime, KernelTime, KernelTime> tuple = state.neuronState_.getSpikes(neuronId);
 
 				const KernelTime previousSpikeTimeRelative0 = kerneltime - std::get<0>(tuple);
 				if ((previousSpikeTimeRelative0 >= 0) && (previousSpikeTimeRelative0 < Options::toKernelTime(Options::kernelRangeThresholdInMs)))
@@ -430,11 +749,46 @@ namespace spike
 
 			void advanceTime(const KernelTime futureTime)
 			{
-				const std::tuple<const IncommingSpike * const, size_t, size_t> tuple = this->state_.incommingSpikes_.advanceCurrentTime(futureTime, this->state_.endRefractoryPeriods_);
+				if (Options::voltageEngine == VoltageEngine::EXPONENTIAL_STATE)
+				{	// the state of a neuron is updated lazily when its voltage is calculated
+					this->state_.voltageState_.advance(this->state_.incommingSpikes_.getCurrentTime());
+				}
+				if (Options::axonalFanOut)
+				{	// the axonal events that arrive in this window become incomming spikes, which are delivered below
+					State<Topology, SpikeStream, SpikeQueue, Synapses>& state = this->state_;
+					state.axonalEvents_.advanceCurrentTime(futureTime, [&state](const AxonalEvent& event)
+					{
+						Network3::expandAxonalEvent(state, event);
+					});
+				}
+				const std::tuple<const IncommingSpike * const, size_t, size_t> tuple = this->state_.incommingSpikes_.advanceCurrentTime(futureTime, this->state_.neuronState_);
 				const IncommingSpike * const nearFutureSpikes = std::get<0>(tuple);
 				const size_t startPos = std::get<1>(tuple);
 				const size_t endPos = std::get<2>(tuple);
 
+				{	// the random spikes that become due in this window
+					State<Topology, SpikeStream, SpikeQueue, Synapses>& state = this->state_;
+					state.randomSpikeScheduler_.advanceCurrentTime(futureTime, [&state](const NeuronId neuronId)
+					{
+						if (Options::useActiveNeuronSet && !Topology::isSensorNeuron(neuronId))
+						{
+							state.activeNeurons_.insert(neuronId);
+						}
+					});
+				}
+				if (Options::useActiveNeuronSet)
+				{
+					for (size_t i = startPos; i < endPos; ++i)
+					{
+						this->state_.activeNeurons_.insert(nearFutureSpikes[i].destination);
+					}
+				}
+
+				if (Options::inferenceOnly)
+				{	// the weights are frozen: no LTD
+					return;
+				}
+
 				//ltd
 				for (size_t i = startPos; i < endPos; ++i)
 				{
@@ -448,13 +802,13 @@ namespace spike
 						const KernelTime incommingTime = incommingSpike.kerneltime;
 
 						// get the time that this destination neuron has spiked
-						const KernelTime timeDiff = incommingTime - this->state_.lastSpikeTime_[destination];
+						const KernelTime timeDiff = incommingTime - this->state_.neuronState_.getLastSpikeTime(destination);
 
 						if ((timeDiff >= 0) && (timeDiff < Options::toKernelTime(Options::kernelRangeStdpInMs)))
 						{
 							const float wD = this->state_.cachedLtd_[timeDiff];
 							//std::cout << "spike::v3::Network3::advanceTime: LTD: neuron " << origin << " contributes at " << incommingTime << " to neuron " << destination << "; Neuron " << destination << " last spiked at " << spikeTime << "; weight decrease " << wD << std::endl;
-							this->state_.synapses_.decWeight(origin, destination, wD);
+							Network3::decWeight(this->state_, this->state_.synapses_->getSynapseId(origin, destination), wD); // derived: a synapse id in IncommingSpike would grow every queued spike
 							//if (dumpWeightDelta) this->dumperWeightDelta_.store_WeightDelta(t, origin, destination, -wD);
 						}
 					}
@@ -490,60 +844,197 @@ namespace spike
 			template <bool dumpSpikes, bool dumpState>
 			void findAndFireNeuronB(const KernelTime currentTime, const KernelTime maxAdvanceTime)
 			{
-				if (Options::useOpenMP)
+				State<Topology, SpikeStream, SpikeQueue, Synapses>& state = this->state_;
+
+				// sensor neurons read and advance the spike stream, they are always handled serially. The stream walks the
+				// precompiled events of the current case instead of being polled for every sensor neuron.
+				state.spikeStream_->forEachSensorSpike(maxAdvanceTime, [&state, currentTime, maxAdvanceTime](const NeuronId neuronId, const KernelTime firingTime)
+				{
+					Network3::fireSensorNeuron<dumpSpikes, dumpState>(state, neuronId, firingTime, currentTime, maxAdvanceTime);
+				});
+
+				Network3::updateNeuronsToTest(state, maxAdvanceTime);
+				state.nNeuronsTestedLastSec_ += state.neuronsToTest_.size();
+
+				if (state.nThreads_ > 1)
 				{
-					/*
-					State<Topology, SpikeStream>& state = this->state_;
-					const int nThreads = std::min(static_cast<int>(Options::maxNumberOfThreads), omp_get_num_procs());
-					#pragma omp parallel for num_threads(nThreads) default(none) shared(state, currentTime, maxAdvanceTime)// schedule(dynamic,1)
-					for (int neuronId = 0; neuronId < static_cast<int>(Options::nNeurons); ++neuronId) {
-						Network3::testAndFireNeuron<dumpSpikes, dumpState>(state, static_cast<NeuronId>(neuronId), currentTime, maxAdvanceTime);
+					// Testing whether a neuron fires in [currentTime, maxAdvanceTime] only reads the state. A firing neuron changes
+					// only its own state and schedules spikes that arrive after maxAdvanceTime; hence the test of one neuron does
+					// not depend on the firing of another neuron in the same window. The test phase is done in parallel, each thread
+					// collects the firing neurons of a contiguous range of neuronIds in its own buffer. The buffers are merged in
+					// thread order, which equals neuronId order, such that fire() is called in the same order as in the serial code.
+					for (std::vector<PostSynapticSpike>& firingBuffer : state.firingBuffers_)
+					{
+						firingBuffer.clear();
+					}
+
+					const int nThreadsRequested = state.nThreads_;
+					#pragma omp parallel num_threads(nThreadsRequested) default(none) shared(state, currentTime, maxAdvanceTime)
+					{
+						const int nThreads = omp_get_num_threads();
+						const int threadId = omp_get_thread_num();
+						const size_t nNeuronsToTest = state.neuronsToTest_.size();
+
+						const size_t begin = Network3::alignToBlock(state, (nNeuronsToTest * threadId) / nThreads);
+						const size_t end = Network3::alignToBlock(state, (nNeuronsToTest * (threadId + 1)) / nThreads);
+						if (Options::useThresholdSweep)
+						{
+							Network3::sweepThreshold(state, begin, end, maxAdvanceTime);
+						}
+
+						std::vector<PostSynapticSpike>& firingBuffer = state.firingBuffers_[threadId];
+						for (size_t i = begin; i < end; ++i)
+						{
+							const NeuronId neuronId = state.neuronsToTest_[i];
+							const PostSynapticSpike spike = (Topology::isMotorNeuron(neuronId))
+								? Network3::test_MotorNeuron(state, neuronId, currentTime, maxAdvanceTime)
+								: Network3::test_ExcInhNeuron(state, neuronId, currentTime, maxAdvanceTime);
+
+							if (spike.firingReason != FiringReason::NO_FIRE)
+							{
+								firingBuffer.push_back(spike);
+							}
+						}
+					}
+
+					for (const std::vector<PostSynapticSpike>& firingBuffer : state.firingBuffers_)
+					{
+						for (const PostSynapticSpike& spike : firingBuffer)
+						{
+							Network3::fire<dumpSpikes, dumpState>(state, currentTime, spike);
+						}
 					}
-					*/
 				}
 				else
+				{	// the neurons to test are in increasing order: first the Exc and Inh neurons, then the Motor neurons
+					if (Options::useThresholdSweep)
+					{	// firing a neuron only changes its own state, hence the sweep can precede the firing of the neurons of the window
+						Network3::sweepThreshold(state, 0, state.neuronsToTest_.size(), maxAdvanceTime);
+					}
+					for (const NeuronId neuronId : state.neuronsToTest_)
+					{
+						if (Topology::isMotorNeuron(neuronId))
+						{
+							Network3::testAndFire_MotorNeuron<dumpSpikes, dumpState>(state, neuronId, currentTime, maxAdvanceTime);
+						}
+						else
+						{
+							Network3::testAndFire_ExcInhNeuron<dumpSpikes, dumpState>(state, neuronId, currentTime, maxAdvanceTime);
+						}
+					}
+				}
+			}
+
+			// Return the number of windows, starting at currentTime, in which nothing can happen: no spike is delivered, no sensor or
+			// random spike is due, no new case starts, and no active neuron can reach its threshold. In such windows the main loop
+			// only advances the time. The voltage upper bound does not depend on time, hence it holds for all these windows.
+			KernelTime getNumberOfSilentWindows(const KernelTime currentTime, const KernelTime windowSize, const KernelTime maxNumberOfWindows) const
+			{
+				if (!Options::skipSilentWindows || !Options::useActiveNeuronSet || !Options::useVoltageUpperBound) return 0;
+
+				const State<Topology, SpikeStream, SpikeQueue, Synapses>& state = this->state_;
+				const KernelTime nextEventTime = std::min(std::min(std::min(
+					state.incommingSpikes_.getNextSpikeTime(),
+					state.axonalEvents_.getNextSpikeTime()),
+					state.randomSpikeScheduler_.getNextSpikeTime()),
+					state.spikeStream_->getNextEventTime());
+
+				if (nextEventTime < (currentTime + windowSize)) return 0;
+
+				bool canFire = false;
+				state.activeNeurons_.forEach([&state, &canFire, currentTime, windowSize](const NeuronId neuronId)
 				{
-					for (const NeuronId neuronId : Topology::iterator_SensorNeurons())
+					if (state.neuronState_.getNextRandomSpikeTime(neuronId) < (currentTime + windowSize))
 					{
-						Network3::testAndFire_SensorNeuron<dumpSpikes, dumpState>(this->state_, neuronId, currentTime, maxAdvanceTime);
+						canFire = true;
 					}
-					for (const NeuronId neuronId : Topology::iterator_ExcInhNeurons())
+					else
 					{
-						Network3::testAndFire_ExcInhNeuron<dumpSpikes, dumpState>(this->state_, neuronId, currentTime, maxAdvanceTime);
+						const std::tuple<const SpikeRecord * const, unsigned int, unsigned int> tuple = state.incommingSpikes_.getPastAndNearFutureSpikes(neuronId);
+						if ((std::get<1>(tuple) < std::get<2>(tuple)) && (Network3::calcVoltageUpperBound(state, neuronId) >= state.minThreshold_))
+						{
+							canFire = true;
+						}
 					}
-					for (const NeuronId neuronId : Topology::iterator_MotorNeurons())
+				});
+				if (canFire) return 0;
+
+				return std::min(maxNumberOfWindows, (nextEventTime - currentTime) / windowSize);
+			}
+
+			// Collect the Exc, Inh and Motor neurons to test in the window that ends at maxAdvanceTime. A neuron without incomming spikes
+			// has a voltage of at most zero (eta is not positive), hence it can only fire when its random spike is due. Neurons that
+			// are neither are removed from the active set; they are added again when a spike is delivered or a random spike becomes due.
+			void static updateNeuronsToTest(State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const KernelTime maxAdvanceTime)
+			{
+				state.neuronsToTest_.clear();
+				if (Options::useActiveNeuronSet)
+				{
+					state.activeNeurons_.forEach([&state, maxAdvanceTime](const NeuronId neuronId)
+					{
+						const std::tuple<const SpikeRecord * const, unsigned int, unsigned int> tuple = state.incommingSpikes_.getPastAndNearFutureSpikes(neuronId);
+						const bool hasIncommingSpikes = std::get<1>(tuple) < std::get<2>(tuple);
+						const bool hasRandomSpike = state.neuronState_.getNextRandomSpikeTime(neuronId) < maxAdvanceTime;
+						if (hasIncommingSpikes || hasRandomSpike)
+						{
+							state.neuronsToTest_.push_back(neuronId);
+						}
+						else
+						{
+							state.activeNeurons_.erase(neuronId);
+						}
+					});
+				}
+				else
+				{
+					for (const NeuronId neuronId : Topology::iterator_ActiveNeurons())
 					{
-						Network3::testAndFire_MotorNeuron<dumpSpikes, dumpState>(this->state_, neuronId, currentTime, maxAdvanceTime);
+						state.neuronsToTest_.push_back(neuronId);
 					}
 				}
 			}
 
 			template <bool dumpSpikes, bool dumpState>
-			void static testAndFire_SensorNeuron(State<Topology, SpikeStream>& state, const NeuronId neuronId, const KernelTime currentTime, const KernelTime maxAdvanceTime)
+			void static fireSensorNeuron(State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const NeuronId neuronId, const KernelTime firingTime, const KernelTime currentTime, const KernelTime maxAdvanceTime)
 			{
-				const std::tuple<bool, KernelTime> tuple = state.spikeStream_->getNextSpikeTimeAndAdvance(neuronId, maxAdvanceTime);
-				if (std::get<0>(tuple))
+				::tools::assert::assert_msg(firingTime <= maxAdvanceTime, "spike::v3::Network:fireSensorNeuron: firingTime ", firingTime, " is larger than maxAdvanceTime ", maxAdvanceTime);
+				::tools::assert::assert_msg(firingTime >= currentTime, "spike::v3::Network:fireSensorNeuron: firingTime ", firingTime, " is smaller than current time ", currentTime);
+
+				if (true && Options::tranceNeuronOn && (neuronId == Options::tranceNeuron))
 				{
-					const KernelTime firingTime = std::get<1>(tuple);
-					::tools::assert::assert_msg(firingTime <= maxAdvanceTime, "spike::v3::Network:testAndFire_SensorNeuron: firingTime ", firingTime, " is larger than maxAdvanceTime ", maxAdvanceTime);
-					::tools::assert::assert_msg(firingTime >= currentTime, "spike::v3::Network:testAndFire_SensorNeuron: firingTime ", firingTime, " is smaller than current time ", currentTime);
+					printf("spike::v3::Network:fireSensorNeuron: SPIKE: neuron=%u; currentTime=%u; fireTime=%u\n", neuronId, currentTime, firingTime);
+				}
 
-					if (true && Options::tranceNeuronOn && (neuronId == Options::tranceNeuron))
-					{
-						printf("spike::v3::Network:testAndFire_SensorNeuron: SPIKE: neuron=%u; currentTime=%u; fireTime=%u\n", neuronId, currentTime, firingTime);
-					}
+				Network3::fire<dumpSpikes, dumpState>(state, currentTime, PostSynapticSpike(firingTime, neuronId, FiringReason::FIRE_CLAMPED));
+			}
 
-					Network3::fire<dumpSpikes, dumpState>(state, currentTime, PostSynapticSpike(firingTime, neuronId, FiringReason::FIRE_CLAMPED));
+			template <bool dumpSpikes, bool dumpState>
+			void static testAndFire_ExcInhNeuron(State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const NeuronId neuronId, const KernelTime currentTime, const KernelTime maxAdvanceTime)
+			{
+				const PostSynapticSpike spike = Network3::test_ExcInhNeuron(state, neuronId, currentTime, maxAdvanceTime);
+				if (spike.firingReason != FiringReason::NO_FIRE)
+				{
+					Network3::fire<dumpSpikes, dumpState>(state, currentTime, spike);
 				}
 			}
 
 			template <bool dumpSpikes, bool dumpState>
-			void static testAndFire_ExcInhNeuron(State<Topology, SpikeStream>& state, const NeuronId neuronId, const KernelTime currentTime, const KernelTime maxAdvanceTime)
+			void static testAndFire_MotorNeuron(State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const NeuronId neuronId, const KernelTime currentTime, const KernelTime maxAdvanceTime)
+			{
+				const PostSynapticSpike spike = Network3::test_MotorNeuron(state, neuronId, currentTime, maxAdvanceTime);
+				if (spike.firingReason != FiringReason::NO_FIRE)
+				{
+					Network3::fire<dumpSpikes, dumpState>(state, currentTime, spike);
+				}
+			}
+
+			// return the spike of the provided neuron in [currentTime, maxAdvanceTime], returns a spike with firing reason NO_FIRE if the neuron does not fire. Does not change the state.
+			PostSynapticSpike static test_ExcInhNeuron(const State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const NeuronId neuronId, const KernelTime currentTime, const KernelTime maxAdvanceTime)
 			{
-				const KernelTime endRefractoryPeriod = std::get<0>(state.endRefractoryPeriods_.getSpikes(neuronId));
+				const KernelTime endRefractoryPeriod = state.neuronState_.getEndRefractoryPeriod(neuronId);
 				if (endRefractoryPeriod < maxAdvanceTime)
 				{
-					const std::tuple<bool, KernelTime, Voltage, Voltage> firingTimeRange = Network3::approximateThresholdCrossingRange(state, neuronId, currentTime, maxAdvanceTime);
+					const std::tuple<bool, KernelTime, Voltage, Voltage> firingTimeRange = Network3::searchThresholdCrossing(state, neuronId, currentTime, maxAdvanceTime);
 					if (std::get<0>(firingTimeRange))
 					{
 						if (true && Options::tranceNeuronOn && (neuronId == Options::tranceNeuron))
@@ -554,27 +1045,28 @@ namespace spike
 						::tools::assert::assert_msg(firingTime >= currentTime, "firingTime ", firingTime, " is smaller than current time ", currentTime);
 						::tools::assert::assert_msg(firingTime <= maxAdvanceTime, "firingTime ", firingTime, " is larger than maxAdvanceTime ", maxAdvanceTime);
 
-						Network3::fire<dumpSpikes, dumpState>(state, currentTime, PostSynapticSpike(firingTime, neuronId, FiringReason::FIRE_PROPAGATED));
+						return PostSynapticSpike(firingTime, neuronId, FiringReason::FIRE_PROPAGATED);
 					}
 					else
 					{
 						// see if the neuron fires randomly
-						const PostSynapticSpike& randomSpike = state.nextRandomPostSynapticSpike_[neuronId];
-						if (randomSpike.kerneltime < maxAdvanceTime)
+						const KernelTime randomSpikeTime = state.neuronState_.getNextRandomSpikeTime(neuronId);
+						if (randomSpikeTime < maxAdvanceTime)
 						{
-							Network3::fire<dumpSpikes, dumpState>(state, currentTime, randomSpike);
+							return PostSynapticSpike(randomSpikeTime, neuronId, FiringReason::FIRE_RANDOM);
 						}
 					}
 				}
+				return PostSynapticSpike();
 			}
 
-			template <bool dumpSpikes, bool dumpState>
-			void static testAndFire_MotorNeuron(State<Topology, SpikeStream>& state, const NeuronId neuronId, const KernelTime currentTime, const KernelTime maxAdvanceTime)
+			// return the spike of the provided motor neuron in [currentTime, maxAdvanceTime], returns a spike with firing reason NO_FIRE if the neuron does not fire. Does not change the state.
+			PostSynapticSpike static test_MotorNeuron(const State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const NeuronId neuronId, const KernelTime currentTime, const KernelTime maxAdvanceTime)
 			{
-				const KernelTime endRefractoryPeriod = std::get<0>(state.endRefractoryPeriods_.getSpikes(neuronId));
+				const KernelTime endRefractoryPeriod = state.neuronState_.getEndRefractoryPeriod(neuronId);
 				if (endRefractoryPeriod < maxAdvanceTime)
 				{
-					const std::tuple<bool, KernelTime, Voltage, Voltage> firingTimeRange = Network3::approximateThresholdCrossingRange(state, neuronId, currentTime, maxAdvanceTime);
+					const std::tuple<bool, KernelTime, Voltage, Voltage> firingTimeRange = Network3::searchThresholdCrossing(state, neuronId, currentTime, maxAdvanceTime);
 					if (std::get<0>(firingTimeRange))
 					{
 						if (true && Options::tranceNeuronOn && (neuronId == Options::tranceNeuron))
@@ -601,22 +1093,209 @@ namespace spike
 
 						//printf("spike::v3::Network:testAndFire_MotorNeuron: SPIKE: neuron=%u; firingReason=%u; currentTime=%u; fireTime=%u; voltage=%f, threshold=%f\n", neuronId, static_cast<int>(firingReason), currentTime, std::get<1>(firingTimeRange), std::get<2>(firingTimeRange), std::get<3>(firingTimeRange));
 
-						Network3::fire<dumpSpikes, dumpState>(state, currentTime, PostSynapticSpike(firingTime, neuronId, firingReason));
+						return PostSynapticSpike(firingTime, neuronId, firingReason);
 					}
 					else
 					{
 						// see if the neuron fires randomly
-						const PostSynapticSpike& randomSpike = state.nextRandomPostSynapticSpike_[neuronId];
-						if (randomSpike.kerneltime < maxAdvanceTime)
+						const KernelTime randomSpikeTime = state.neuronState_.getNextRandomSpikeTime(neuronId);
+						if (randomSpikeTime < maxAdvanceTime)
 						{
-							Network3::fire<dumpSpikes, dumpState>(state, currentTime, randomSpike);
+							return PostSynapticSpike(randomSpikeTime, neuronId, FiringReason::FIRE_RANDOM);
+						}
+					}
+				}
+				return PostSynapticSpike();
+			}
+
+			// return the first time in [currentTime, maxAdvanceTime] at which the voltage of the provided neuron crosses its threshold
+			std::tuple<bool, KernelTime, Voltage, Voltage> static searchThresholdCrossing(const State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const NeuronId neuronId, const KernelTime currentTime, const KernelTime maxAdvanceTime)
+			{
+				if (Network3::isBelowThresholdBound(state, neuronId))
+				{
+					return std::make_tuple(false, static_cast<KernelTime>(0), static_cast<Voltage>(0), static_cast<Voltage>(0));
+				}
+				if (Options::useThresholdSweep)
+				{	// the voltage and threshold at maxAdvanceTime have been computed by sweepThreshold
+					const typename NeuronStateBlocks<Topology>::Block& block = state.neuronState_.getBlock(NeuronStateBlocks<Topology>::getBlockId(neuronId));
+					const size_t lane = NeuronStateBlocks<Topology>::getLane(neuronId);
+					if (!state.neuronState_.isCandidate(neuronId))
+					{
+						return std::make_tuple(false, static_cast<KernelTime>(0), block.voltage[lane], block.threshold[lane]);
+					}
+					return Network3::approximateThresholdCrossingRange(state, neuronId, currentTime, maxAdvanceTime, block.voltage[lane], block.threshold[lane]);
+				}
+				return Network3::approximateThresholdCrossingRange(state, neuronId, currentTime, maxAdvanceTime);
+			}
+
+			// Compute the voltage and threshold at maxAdvanceTime of the neurons at positions [begin, end) of neuronsToTest_, one block
+			// of NeuronStateBlocks at a time: the voltages are computed per neuron, the thresholds and the comparison with the voltage are
+			// one SIMD sweep over the block. Only the neurons with a voltage above the threshold are searched for the exact crossing.
+			// The positions [begin, end) have to contain whole blocks, such that threads do not write the same block.
+			void static sweepThreshold(State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const size_t begin, const size_t end, const KernelTime maxAdvanceTime)
+			{
+				const ThresholdSweep& thresholdSweep = ThresholdSweep::getInstance();
+				const KernelTime tableSize = Options::toKernelTime(Options::kernelRangeThresholdInMs);
+
+				size_t i = begin;
+				while (i < end)
+				{
+					const size_t blockId = NeuronStateBlocks<Topology>::getBlockId(state.neuronsToTest_[i]);
+					typename NeuronStateBlocks<Topology>::Block& block = state.neuronState_.getBlock(blockId);
+					std::uint32_t laneMask = 0;
+
+					for (; (i < end) && (NeuronStateBlocks<Topology>::getBlockId(state.neuronsToTest_[i]) == blockId); ++i)
+					{
+						const NeuronId neuronId = state.neuronsToTest_[i];
+						const size_t lane = NeuronStateBlocks<Topology>::getLane(neuronId);
+						laneMask |= (1u << lane);
+
+						const bool needsVoltage = (block.endRefractoryPeriod[0][lane] < maxAdvanceTime) &&
+							(!Options::useVoltageUpperBound || (Network3::calcVoltageUpperBound(state, neuronId) >= state.minThreshold_));
+						block.voltage[lane] = (needsVoltage) ? Network3::calcVoltage(state, neuronId, maxAdvanceTime) : Options::minVoltage;
+					}
+					block.candidates = thresholdSweep.sweep(block.endRefractoryPeriod[0], block.voltage, laneMask, maxAdvanceTime, state.cachedThreshold_.data(), tableSize, Options::minimalThreshold, block.threshold);
+				}
+			}
+
+			// return the id of the calling thread in the team of this network: 0 when the network runs on one thread, also when the
+			// caller is a thread of an enclosing team (e.g. BatchEvaluator::evaluate)
+			int static getThreadId(const State<Topology, SpikeStream, SpikeQueue, Synapses>& state)
+			{
+				return (state.nThreads_ > 1) ? omp_get_thread_num() : 0;
+			}
+
+			// return the first position at or after pos in neuronsToTest_ that starts a new block of NeuronStateBlocks
+			size_t static alignToBlock(const State<Topology, SpikeStream, SpikeQueue, Synapses>& state, size_t pos)
+			{
+				while ((pos > 0) && (pos < state.neuronsToTest_.size()) &&
+					(NeuronStateBlocks<Topology>::getBlockId(state.neuronsToTest_[pos]) == NeuronStateBlocks<Topology>::getBlockId(state.neuronsToTest_[pos - 1])))
+				{
+					++pos;
+				}
+				return pos;
+			}
+
+			// Return an upper bound of the voltage of the provided neuron that holds until new spikes are delivered to it: the voltage is
+			// at most maxEta_ plus maxEpsilon_ times the sum of the positive efficacies of its incomming spikes. The margin covers
+			// differences in float rounding; with VoltageEngine::EXPONENTIAL_STATE the bound is conservative up to the deviation of that engine.
+			double static calcVoltageUpperBound(const State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const NeuronId neuronId)
+			{
+				const double margin = 0.01;
+				return state.maxEta_ + (state.incommingSpikes_.getPositiveEfficacySum(neuronId) * state.maxEpsilon_) + margin;
+			}
+
+			// return true if the voltage of the provided neuron cannot reach the threshold, which is at least minThreshold_
+			bool static isBelowThresholdBound(const State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const NeuronId neuronId)
+			{
+				if (!Options::useVoltageUpperBound) return false;
+
+				const bool belowThreshold = Network3::calcVoltageUpperBound(state, neuronId) < state.minThreshold_;
+
+				ThreadStatistics& statistics = state.threadStatistics_[Network3::getThreadId(state)];
+				statistics.nNeuronTests++;
+				if (belowThreshold) statistics.nNeuronTestsSkipped++;
+				return belowThreshold;
+			}
+
+			// return the label of the motor neuron that has won according to Options::decisionPolicy, NO_CASE_LABEL if there is no
+			// decision yet. When several motor neurons qualify in the same window, the one with the most spikes (then the lowest) wins.
+			CaseLabel static getDecision(const std::array<unsigned int, Topology::Nm>& motorSpikeCount)
+			{
+				if (Options::decisionPolicy == DecisionPolicy::NONE)
+				{
+					return NO_CASE_LABEL;
+				}
+				unsigned int first = 0;
+				unsigned int second = 0;
+				CaseLabelType label = 0;
+				for (CaseLabelType i = 0; i < static_cast<CaseLabelType>(Topology::Nm); ++i)
+				{
+					if (motorSpikeCount[i] > first)
+					{
+						second = first;
+						first = motorSpikeCount[i];
+						label = i;
+					}
+					else if (motorSpikeCount[i] > second)
+					{
+						second = motorSpikeCount[i];
+					}
+				}
+				const bool decided = (Options::decisionPolicy == DecisionPolicy::FIRST_SPIKES)
+					? (first >= Options::decisionSpikes)
+					: (first >= (second + Options::decisionSpikes));
+				return (decided) ? CaseLabel(label) : NO_CASE_LABEL;
+			}
+
+			// change the weight of the provided synapse now, or with Options::deferWeightUpdates at the next flush
+			void static incWeight(State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const SynapseId synapseId, const float value)
+			{
+				if (Options::deferWeightUpdates)
+				{
+					state.synapses_->incWeightDeferred(synapseId, value);
+				}
+				else
+				{
+					state.synapses_->incWeight(synapseId, value);
+				}
+			}
+
+			void static decWeight(State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const SynapseId synapseId, const float value)
+			{
+				if (Options::deferWeightUpdates)
+				{
+					state.synapses_->decWeightDeferred(synapseId, value);
+				}
+				else
+				{
+					state.synapses_->decWeight(synapseId, value);
+				}
+			}
+
+			// LTP of the provided synapse, which delivered a spike timeDiff before its destination fired
+			void static applyLtp(State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const SynapseId synapseId, const KernelTime timeDiff, const FiringReason firingReason)
+			{
+				const float wD = state.cachedLtp_[timeDiff];
+				if (firingReason == FiringReason::FIRE_PROPAGATED_INCORRECT)
+				{
+					Network3::decWeight(state, synapseId, wD);
+				}
+				else if (firingReason == FiringReason::FIRE_PROPAGATED_CORRECT)
+				{
+					Network3::incWeight(state, synapseId, 10 * wD);
+				}
+				else
+				{
+					Network3::incWeight(state, synapseId, wD);
+					//if (dumpWeightDelta) this->dumperWeightDelta_.store_WeightDelta(fireTime, contributingNeuronId, neuronId, wD);
+				}
+			}
+
+			// schedule the incomming spikes of the provided axonal event. The weight and the last deliver time (for LTP) of the synapses
+			// are those at the window of arrival, not at the firing of the origin as without Options::axonalFanOut
+			void static expandAxonalEvent(State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const AxonalEvent& event)
+			{
+				const DelayGroup& delayGroup = state.synapses_->getOutgoingDelayGroups(event.origin)[event.delayGroup];
+				for (const SynapseId synapseId : state.synapses_->getOutgoingSynapses(event.origin, delayGroup))
+				{
+					const NeuronId destination = state.synapses_->getDestination(synapseId);
+					if (!Options::inferenceOnly)
+					{
+						state.synapses_->setLastDeliverTime(synapseId, event.kerneltime);
+						if ((Options::plasticityEngine == PlasticityEngine::RECENT_DELIVERIES) && !Topology::isInhNeuron(event.origin))
+						{	// for LTP when the destination fires
+							state.recentDeliveries_.add(destination, event.kerneltime, synapseId);
 						}
 					}
+					const float weight = state.synapses_->getWeight(synapseId);
+					state.incommingSpikes_.sheduleIncommingSpike(event.kerneltime, event.origin, destination, weight);
+					state.nSynapticEventsLastSec_++;
 				}
 			}
 
 			template <bool dumpSpikes, bool dumpState>
-			void static fire(State<Topology, SpikeStream>& state, const KernelTime currentTime, const PostSynapticSpike nextPostSynapticSpike)
+			void static fire(State<Topology, SpikeStream, SpikeQueue, Synapses>& state, const KernelTime currentTime, const PostSynapticSpike nextPostSynapticSpike)
 			{
 				const NeuronId neuronId = nextPostSynapticSpike.neuronId;
 				const KernelTime fireTime = nextPostSynapticSpike.kerneltime;
@@ -635,23 +1314,39 @@ namespace spike
 				else
 				{
 					state.nSpikesRandomLastSec_++;
+					if ((nextPostSynapticSpike.firingReason == FiringReason::FIRE_PROPAGATED_CORRECT) || (nextPostSynapticSpike.firingReason == FiringReason::FIRE_PROPAGATED_INCORRECT))
+					{
+						state.motorSpikeCount_[neuronId - Topology::Nm_start]++;
+					}
 				}
 
 				//1] update the last spike time of this neuron;
-				state.lastSpikeTime_[neuronId] = fireTime;
+				state.neuronState_.setLastSpikeTime(neuronId, fireTime);
 				const KernelTime endRefractoryPeriod = fireTime + Options::toKernelTime(Options::refractoryPeriod);
-				state.endRefractoryPeriods_.addSpike(neuronId, endRefractoryPeriod);
+				state.neuronState_.addSpike(neuronId, endRefractoryPeriod);
 
 				//2] update the next random spike for this neurons such that this random spike is in the future after the refractory period.
 				Network3::updateNextRandomPostSynapticSpike(state, neuronId, endRefractoryPeriod);
 
 				//3] a spike remove the contributions to the state of all previous incomming spikes.
 				state.incommingSpikes_.cleanup(neuronId);
+				state.voltageState_.reset(neuronId);
 
+				if (Options::axonalFanOut)
+				{	//4] for all outgoing delay groups shedule an axonal event, which is expanded into incomming spikes when it arrives
+					const std::vector<DelayGroup>& delayGroups = state.synapses_->getOutgoingDelayGroups(neuronId);
+					for (unsigned int i = 0; i < static_cast<unsigned int>(delayGroups.size()); ++i)
+					{
+						state.axonalEvents_.sheduleAxonalEvent(fireTime + delayGroups[i].delay, neuronId, i);
+						state.nQueueInsertionsLastSec_++;
+					}
+				}
+				else
 				{	//4] for all outgoing pathways shedule a incomming spike somewhere in the future
-					for (const NeuronId& destination : state.synapses_.getDestinations(neuronId))
+					for (const SynapseId synapseId : state.synapses_->getOutgoingSynapses(neuronId))
 					{
-						const KernelTime delay = state.synapses_.getDelay(neuronId, destination);
+						const NeuronId destination = state.synapses_->getDestination(synapseId);
+						const KernelTime delay = state.synapses_->getDelay(synapseId);
 
 						::tools::assert::assert_msg(delay >= Options::toKernelTime(static_cast<TimeInMs>(Options::minDelay)), "spike::v3::Network3::fire: delay is too small; delay=", delay);
 						const KernelTime arrivalTime = fireTime + delay;
@@ -661,37 +1356,53 @@ namespace spike
 							printf("spike::v3::Network3::fire: neuron %u fires at %5u: delivers spike at neuron %u at time %5u\n", neuronId, fireTime, destination, arrivalTime);
 						}
 
-						//for LTD: store at what time a spike is received at destination
-						state.synapses_.setLastDeliverTime(neuronId, destination, arrivalTime);
-						const float weight = state.synapses_.getWeight(neuronId, destination);
+						if (!Options::inferenceOnly)
+						{	//for LTP: store at what time a spike is received at destination
+							state.synapses_->setLastDeliverTime(synapseId, arrivalTime);
+							if ((Options::plasticityEngine == PlasticityEngine::RECENT_DELIVERIES) && !Topology::isInhNeuron(neuronId))
+							{
+								state.recentDeliveries_.add(destination, arrivalTime, synapseId);
+							}
+						}
+						const float weight = state.synapses_->getWeight(synapseId);
 						state.incommingSpikes_.sheduleIncommingSpike(arrivalTime, neuronId, destination, weight);
+						state.nSynapticEventsLastSec_++;
+						state.nQueueInsertionsLastSec_++;
 					}
 				}
+				if (Options::inferenceOnly)
+				{	//5] the weights are frozen: no LTP
+				}
+				else if (Options::plasticityEngine == PlasticityEngine::RECENT_DELIVERIES)
+				{	//5] for all synapses that delivered a spike within the STDP range: increase their weights.
+					const KernelTime timeHorizon = fireTime - Options::toKernelTime(Options::kernelRangeStdpInMs);
+					state.recentDeliveries_.forEach(neuronId, timeHorizon, [&state, fireTime, &nextPostSynapticSpike](const SynapseId synapseId, const KernelTime deliverTime)
+					{
+						// only the last spike scheduled over a synapse counts, as with PlasticityEngine::PAIR_SCAN
+						if (deliverTime == state.synapses_->getLastDeliverTime(synapseId))
+						{
+							const KernelTime timeDiff = fireTime - deliverTime;
+							if (timeDiff >= 0)
+							{
+								Network3::applyLtp(state, synapseId, timeDiff, nextPostSynapticSpike.firingReason);
+							}
+						}
+					});
+				}
+				else
 				{	//5] for all contributing spike of the current spike: increase their weights.
-					for (const NeuronId& contributingNeuronId : state.synapses_.getOrigins(neuronId))
+					for (const SynapseId synapseId : state.synapses_->getIncommingSynapses(neuronId))
 					{
+						const NeuronId contributingNeuronId = state.synapses_->getOrigin(synapseId);
 						if (!Topology::isInhNeuron(contributingNeuronId))
 						{ // only update weights of excitatory neurons
-							const KernelTime contributionTime = state.synapses_.getLastDeliverTime(contributingNeuronId, neuronId);
+							const KernelTime contributionTime = state.synapses_->getLastDeliverTime(synapseId);
 							const KernelTime timeDiff = fireTime - contributionTime;
 
 							if ((timeDiff >= 0) && (timeDiff < Options::toKernelTime(Options::kernelRangeStdpInMs)))
 							{
-								const float wD = state.cachedLtp_[timeDiff];
-								//std::cout << "spike::v3::Network3::fire: LTP: neuron " << neuronId << " fires at " << fireTime << "; neuron " << contributingNeuronId << " contributed at time " << contributionTime << "; timeDiff="<<timeDiff<<"; weight increase " << wD << std::endl;
-								if (nextPostSynapticSpike.firingReason == FiringReason::FIRE_PROPAGATED_INCORRECT)
-								{
-									state.synapses_.decWeight(contributingNeuronId, neuronId, wD);
-								}
-								else if (nextPostSynapticSpike.firingReason == FiringReason::FIRE_PROPAGATED_CORRECT)
-								{
-									state.synapses_.incWeight(contributingNeuronId, neuronId, 10 * wD);
-								}
-								else
-								{
-									state.synapses_.incWeight(contributingNeuronId, neuronId, wD);
-									//if (dumpWeightDelta) this->dumperWeightDelta_.store_WeightDelta(fireTime, contributingNeuronId, neuronId, wD);
-								}
+								//std::cout << "spike::v3::Network3::fire: LTP: neuron " << neuronId << " fires at " << fireTime << "; neuron " << contributingNeuronId << " contributed at time " << contributionTime << "; timeDiff="<<timeDiff<<std::endl;
+								Network3::applyLtp(state, synapseId, timeDiff, nextPostSynapticSpike.firingReason);
 							}
 						}
 					}
@@ -725,17 +1436,29 @@ namespace spike
 			}
 
 			std::tuple<bool, KernelTime, Voltage, Voltage> static approximateThresholdCrossingRange(
-				const State<Topology, SpikeStream>& state,
+				const State<Topology, SpikeStream, SpikeQueue, Synapses>& state,
 				const NeuronId neuronId,
 				const KernelTime startTime,
 				const KernelTime endTime)
+			{
+				return Network3::approximateThresholdCrossingRange(state, neuronId, startTime, endTime,
+					Network3::calcVoltage(state, neuronId, endTime),
+					Network3::calcThreshold(state, neuronId, endTime));
+			}
+
+			// as approximateThresholdCrossingRange, with the voltage v2 and threshold threshold2 at endTime already computed
+			std::tuple<bool, KernelTime, Voltage, Voltage> static approximateThresholdCrossingRange(
+				const State<Topology, SpikeStream, SpikeQueue, Synapses>& state,
+				const NeuronId neuronId,
+				const KernelTime startTime,
+				const KernelTime endTime,
+				const Voltage v2,
+				const Voltage threshold2)
 			{
 				::tools::assert::assert_msg(startTime <= endTime, "spike::v3::Network: approximateThresholdCrossingRange");
 				KernelTime t0 = startTime;
 				KernelTime t2 = endTime;
 
-				const Voltage v2 = Network3::calcVoltage(state, neuronId, t2);
-				const Voltage threshold2 = Network3::calcThreshold(state, neuronId, t2);
 				if (v2 <= threshold2)
 				{
 
@@ -813,9 +1536,9 @@ namespace spike
 			{
 				double sum = 0;
 				size_t counter = 0;
-				for (const NeuronId& destination : this->state_.synapses_.getDestinations(neuronId))
+				for (const SynapseId synapseId : this->state_.synapses_->getOutgoingSynapses(neuronId))
 				{
-					sum += this->state_.synapses_.getWeight(neuronId, destination);
+					sum += this->state_.synapses_->getWeight(synapseId);
 					counter++;
 				}
 				return static_cast<float>(((sum == 0) || (counter == 0)) ? 0 : (sum / counter));
@@ -825,9 +1548,9 @@ namespace spike
 			{
 				double sum = 0;
 				size_t counter = 0;
-				for (const NeuronId& origin : this->state_.synapses_.getOrigins(neuronId))
+				for (const SynapseId synapseId : this->state_.synapses_->getIncommingSynapses(neuronId))
 				{
-					sum += this->state_.synapses_.getWeight(origin, neuronId);
+					sum += this->state_.synapses_->getWeight(synapseId);
 					counter++;
 				}
 				return static_cast<float>(((sum == 0) || (counter == 0)) ? 0 : (sum / counter));
@@ -881,13 +1604,13 @@ namespace spike
 				std::cout << "spike::v3::Network3::substractTime: time=" << time << std::endl;
 
 				this->state_.lastTimeStateDumped_ -= time;
-				for (const NeuronId neuronId : Topology::iterator_AllNeurons())
-				{
-					this->state_.lastSpikeTime_[neuronId] -= time;
-					this->state_.nextRandomPostSynapticSpike_[neuronId].kerneltime -= time;
-				}
+				this->state_.neuronState_.substractTime(time);
 				this->state_.incommingSpikes_.substractTime(time);
-				this->state_.endRefractoryPeriods_.substractTime(time);
+				this->state_.axonalEvents_.substractTime(time);
+				this->state_.nextWeightFlushTime_ -= time;
+				this->state_.recentDeliveries_.substractTime(time);
+				this->state_.randomSpikeScheduler_.substractTime(time);
+				this->state_.voltageState_.substractTime(time);
 				this->state_.spikeStream_->substractTime(time);
 			}
 
@@ -896,46 +1619,22 @@ namespace spike
 				topology->clearPathways();
 				for (const NeuronId origin : Topology::iterator_AllNeurons())
 				{
-					for (const NeuronId& destination : this->state_.synapses_.getDestinations(origin))
+					for (const SynapseId synapseId : this->state_.synapses_->getOutgoingSynapses(origin))
 					{
-						const Efficacy efficacy = this->state_.synapses_.getWeight(origin, destination);
-						const KernelTime delay = this->state_.synapses_.getDelay(origin, destination);
+						const NeuronId destination = this->state_.synapses_->getDestination(synapseId);
+						const Efficacy efficacy = this->state_.synapses_->getWeight(synapseId);
+						const KernelTime delay = this->state_.synapses_->getDelay(synapseId);
 						topology->addPathway(origin, destination, static_cast<Delay>(Options::toTimeInMs(delay)), efficacy);
 					}
 				}
 			}
 
 			void static updateNextRandomPostSynapticSpike(
-				State<Topology, SpikeStream>& state,
+				State<Topology, SpikeStream, SpikeQueue, Synapses>& state,
 				const NeuronId neuronId,
 				const KernelTime currentTime)
 			{
-				state.nextRandomPostSynapticSpike_[neuronId].neuronId = neuronId;
-				state.nextRandomPostSynapticSpike_[neuronId].kerneltime = Network3::getNextRandomSpikeTime(neuronId, currentTime);
-				state.nextRandomPostSynapticSpike_[neuronId].firingReason = FiringReason::FIRE_RANDOM;
-				//std::cout << "updateNextRandomPostSynapticSpike: " << this->nextRandomPostSynapticSpike_.toString() << std::endl;
-			}
-
-			KernelTime static getNextRandomSpikeTime(const NeuronId /*neuronId*/, const KernelTime lastSpikeTime)
-			{
-				const float targetHz = Options::randomSpikeHz;
-				const double averageTimeBetweenSpikes = 2000.0 / targetHz;
-				const double r = static_cast<double>(rand() + 1) / RAND_MAX;
-				const TimeInMs timeDelta = static_cast<TimeInMs>(averageTimeBetweenSpikes * r);
-
-
-				KernelTime nextRandomSpikeTime;
-				if (std::isfinite(timeDelta))
-				{
-					nextRandomSpikeTime = lastSpikeTime + Options::toKernelTime(timeDelta);
-				}
-				else
-				{
-					nextRandomSpikeTime = lastSpikeTime + 1;
-				}
-
-				//std::cout << "spike::v3::Network3::getNextRandomSpikeTime: neuronId=" << neuronId << "; nextRandomSpikeTime = " << nextRandomSpikeTime << "; targetHz=" << targetHz << "; averageTimeBetweenSpikes=" << averageTimeBetweenSpikes << "; r=" << r << "; timeDelta=" << timeDelta << std::endl;
-				return nextRandomSpikeTime;
+				state.neuronState_.setNextRandomSpikeTime(neuronId, state.randomSpikeScheduler_.scheduleNext(neuronId, currentTime));
 			}
 		};
 	}
@@ -0,0 +1,104 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "Types.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// return the index of the lowest set bit of a word that is not zero
+		inline unsigned int countTrailingZeros(const std::uint64_t word)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward64(&index, word);
+			return static_cast<unsigned int>(index);
+#else
+			return static_cast<unsigned int>(__builtin_ctzll(word));
+#endif
+		}
+
+		// set of neuron ids stored as a bit mask; iterating the set visits the neurons in increasing order
+		template <size_t nNeurons>
+		class NeuronBitSet
+		{
+		public:
+
+			// constructor
+			NeuronBitSet()
+			{
+				this->clear();
+			}
+
+			void insert(const NeuronId neuronId)
+			{
+				this->words_[neuronId >> 6] |= (static_cast<std::uint64_t>(1) << (neuronId & 63));
+			}
+
+			void erase(const NeuronId neuronId)
+			{
+				this->words_[neuronId >> 6] &= ~(static_cast<std::uint64_t>(1) << (neuronId & 63));
+			}
+
+			bool contains(const NeuronId neuronId) const
+			{
+				return ((this->words_[neuronId >> 6] >> (neuronId & 63)) & 1) != 0;
+			}
+
+			void clear()
+			{
+				this->words_.fill(0);
+			}
+
+			// call f(neuronId) for every neuron in the set in increasing order; f is allowed to erase the provided neuron
+			template <typename F>
+			void forEach(F f) const
+			{
+				for (size_t i = 0; i < nWords; ++i)
+				{
+					std::uint64_t word = this->words_[i];
+					while (word != 0)
+					{
+						const NeuronId neuronId = static_cast<NeuronId>((i << 6) + countTrailingZeros(word));
+						word &= (word - 1); // remove the lowest set bit
+						f(neuronId);
+					}
+				}
+			}
+
+		private:
+
+			static const size_t nWords = (nNeurons + 63) / 64;
+			std::array<std::uint64_t, nWords> words_;
+		};
+	}
+}
@@ -0,0 +1,308 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <cstdint>
+
+#include "Types.hpp"
+#include "SimdIsa.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// Per neuron state that is read when testing whether a neuron fires, as structure of arrays in blocks of 16 neurons: every
+		// field of a block is one cache line. Holds the ends of the refractory periods of the last four spikes (most recent first),
+		// the last spike time and the time of the next random spike. The voltage, threshold and candidates fields are written
+		// by the threshold sweep of Network3 at the end of every window.
+		template <typename Topology_i>
+		class NeuronStateBlocks
+		{
+		public:
+
+			using Topology = Topology_i;
+			using Options = typename Topology_i::Options;
+
+			static const size_t blockSize = 16;
+			static const size_t nBlocks = (Options::nNeurons + blockSize - 1) / blockSize;
+
+			struct alignas(64) Block
+			{
+				KernelTime endRefractoryPeriod[4][blockSize];
+				KernelTime lastSpikeTime[blockSize];
+				KernelTime nextRandomSpikeTime[blockSize];
+				Voltage voltage[blockSize]; // voltage at the end of the window
+				Voltage threshold[blockSize]; // threshold at the end of the window
+				std::uint32_t candidates; // lanes with a voltage not at or below the threshold at the end of the window
+			};
+
+			// constructor
+			NeuronStateBlocks()
+			{
+				this->clear();
+			}
+
+			// the state of neurons that have never fired
+			void clear()
+			{
+				const KernelTime lastSpikeTime = -1000 * Options::nSubMs;
+				for (Block& block : this->blocks_)
+				{
+					for (size_t lane = 0; lane < blockSize; ++lane)
+					{
+						for (size_t i = 0; i < 4; ++i)
+						{
+							block.endRefractoryPeriod[i][lane] = lastSpikeTime;
+						}
+						block.lastSpikeTime[lane] = lastSpikeTime;
+						block.nextRandomSpikeTime[lane] = NO_KERNEL_TIME;
+						block.voltage[lane] = 0;
+						block.threshold[lane] = 0;
+					}
+					block.candidates = 0;
+				}
+			}
+
+			static size_t getBlockId(const NeuronId neuronId)
+			{
+				return neuronId / blockSize;
+			}
+
+			static size_t getLane(const NeuronId neuronId)
+			{
+				return neuronId % blockSize;
+			}
+
+			const Block& getBlock(const size_t blockId) const
+			{
+				return this->blocks_[blockId];
+			}
+
+			Block& getBlock(const size_t blockId)
+			{
+				return this->blocks_[blockId];
+			}
+
+			// return the ends of the refractory periods of the last four spikes, most recent first
+			std::tuple<KernelTime, KernelTime, KernelTime, KernelTime> getSpikes(const NeuronId neuronId) const
+			{
+				const Block& block = this->blocks_[getBlockId(neuronId)];
+				const size_t lane = getLane(neuronId);
+				return std::make_tuple(block.endRefractoryPeriod[0][lane], block.endRefractoryPeriod[1][lane], block.endRefractoryPeriod[2][lane], block.endRefractoryPeriod[3][lane]);
+			}
+
+			KernelTime getEndRefractoryPeriod(const NeuronId neuronId) const
+			{
+				return this->blocks_[getBlockId(neuronId)].endRefractoryPeriod[0][getLane(neuronId)];
+			}
+
+			void addSpike(const NeuronId neuronId, const KernelTime endRefractoryPeriod)
+			{
+				Block& block = this->blocks_[getBlockId(neuronId)];
+				const size_t lane = getLane(neuronId);
+				block.endRefractoryPeriod[3][lane] = block.endRefractoryPeriod[2][lane];
+				block.endRefractoryPeriod[2][lane] = block.endRefractoryPeriod[1][lane];
+				block.endRefractoryPeriod[1][lane] = block.endRefractoryPeriod[0][lane];
+				block.endRefractoryPeriod[0][lane] = endRefractoryPeriod;
+			}
+
+			KernelTime getLastSpikeTime(const NeuronId neuronId) const
+			{
+				return this->blocks_[getBlockId(neuronId)].lastSpikeTime[getLane(neuronId)];
+			}
+
+			void setLastSpikeTime(const NeuronId neuronId, const KernelTime kerneltime)
+			{
+				this->blocks_[getBlockId(neuronId)].lastSpikeTime[getLane(neuronId)] = kerneltime;
+			}
+
+			KernelTime getNextRandomSpikeTime(const NeuronId neuronId) const
+			{
+				return this->blocks_[getBlockId(neuronId)].nextRandomSpikeTime[getLane(neuronId)];
+			}
+
+			void setNextRandomSpikeTime(const NeuronId neuronId, const KernelTime kerneltime)
+			{
+				this->blocks_[getBlockId(neuronId)].nextRandomSpikeTime[getLane(neuronId)] = kerneltime;
+			}
+
+			// return true if the voltage of the provided neuron was above its threshold at the end of the window of the last sweep
+			bool isCandidate(const NeuronId neuronId) const
+			{
+				return ((this->blocks_[getBlockId(neuronId)].candidates >> getLane(neuronId)) & 1) != 0;
+			}
+
+			void substractTime(const KernelTime time)
+			{
+				for (Block& block : this->blocks_)
+				{
+					for (size_t lane = 0; lane < blockSize; ++lane)
+					{
+						for (size_t i = 0; i < 4; ++i)
+						{
+							block.endRefractoryPeriod[i][lane] -= time;
+						}
+						block.lastSpikeTime[lane] -= time;
+						if (block.nextRandomSpikeTime[lane] != NO_KERNEL_TIME) block.nextRandomSpikeTime[lane] -= time; // lanes without a random spike keep NO_KERNEL_TIME, as in RandomSpikeScheduler
+					}
+				}
+			}
+
+		private:
+
+			std::array<Block, nBlocks> blocks_;
+		};
+
+		// The threshold of the 16 neurons of a NeuronStateBlocks block at one time, and the comparison with their voltage. The threshold
+		// is minimalThreshold times the threshold kernel of the last four spikes; the kernel entries of the 16 lanes are gathered at
+		// once. The factors are multiplied in the same order as in Network3::calcThreshold, hence the result is bit identical.
+		// SSE4.1 has no gather instruction, it uses the scalar sweep.
+		class ThresholdSweep
+		{
+		public:
+
+			using Function = std::uint32_t(*)(const KernelTime * endRefractoryPeriod, const Voltage * voltage, std::uint32_t laneMask, KernelTime kerneltime, const float * table, KernelTime tableSize, Voltage minimalThreshold, Voltage * threshold);
+
+			static const size_t blockSize = 16;
+
+			// constructor: select the sweep of the best supported instruction set
+			ThresholdSweep()
+				: ThresholdSweep(detectSimdIsa())
+			{
+			}
+
+			// constructor: select the sweep of the provided instruction set, which has to be supported by the cpu
+			ThresholdSweep(const SimdIsa isa)
+				: isa_(isa)
+				, function_(getFunction(isa))
+			{
+			}
+
+			SimdIsa getIsa() const
+			{
+				return this->isa_;
+			}
+
+			// Write the threshold at the provided time of all lanes to threshold, and return the lanes in laneMask with a voltage that is
+			// not at or below the threshold. endRefractoryPeriod holds 4 rows of 16 lanes.
+			std::uint32_t sweep(const KernelTime * const endRefractoryPeriod, const Voltage * const voltage, const std::uint32_t laneMask, const KernelTime kerneltime, const float * const table, const KernelTime tableSize, const Voltage minimalThreshold, Voltage * const threshold) const
+			{
+				return this->function_(endRefractoryPeriod, voltage, laneMask, kerneltime, table, tableSize, minimalThreshold, threshold);
+			}
+
+			// the sweep of the best supported instruction set, detected once
+			static const ThresholdSweep& getInstance()
+			{
+				static const ThresholdSweep instance;
+				return instance;
+			}
+
+			static std::uint32_t sweep_Scalar(const KernelTime * const endRefractoryPeriod, const Voltage * const voltage, const std::uint32_t laneMask, const KernelTime kerneltime, const float * const table, const KernelTime tableSize, const Voltage minimalThreshold, Voltage * const threshold)
+			{
+				std::uint32_t result = 0;
+				for (size_t lane = 0; lane < blockSize; ++lane)
+				{
+					Voltage t = minimalThreshold;
+					for (size_t i = 0; i < 4; ++i)
+					{
+						const KernelTime relativeTime = kerneltime - endRefractoryPeriod[(i * blockSize) + lane];
+						if ((relativeTime >= 0) && (relativeTime < tableSize))
+						{
+							t *= table[relativeTime];
+						}
+					}
+					threshold[lane] = t;
+					if (!(voltage[lane] <= t)) // as in Network3::approximateThresholdCrossingRange: a NaN voltage is searched
+					{
+						result |= (1u << lane);
+					}
+				}
+				return result & laneMask;
+			}
+
+#if defined(SPIKE_SIMD_X86)
+			SPIKE_TARGET_AVX2
+			static std::uint32_t sweep_Avx2(const KernelTime * const endRefractoryPeriod, const Voltage * const voltage, const std::uint32_t laneMask, const KernelTime kerneltime, const float * const table, const KernelTime tableSize, const Voltage minimalThreshold, Voltage * const threshold)
+			{
+				std::uint32_t result = 0;
+				for (size_t half = 0; half < blockSize; half += 8)
+				{
+					__m256 t = _mm256_set1_ps(minimalThreshold);
+					for (size_t i = 0; i < 4; ++i)
+					{
+						const __m256i endTimes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(endRefractoryPeriod + (i * blockSize) + half));
+						const __m256i relativeTime = _mm256_sub_epi32(_mm256_set1_epi32(kerneltime), endTimes);
+						const __m256i inRange = _mm256_andnot_si256(
+							_mm256_cmpgt_epi32(_mm256_setzero_si256(), relativeTime),
+							_mm256_cmpgt_epi32(_mm256_set1_epi32(tableSize), relativeTime));
+						const __m256 factor = _mm256_mask_i32gather_ps(_mm256_set1_ps(1.0f), table, relativeTime, _mm256_castsi256_ps(inRange), 4);
+						t = _mm256_mul_ps(t, factor);
+					}
+					_mm256_storeu_ps(threshold + half, t);
+					const __m256 above = _mm256_cmp_ps(_mm256_loadu_ps(voltage + half), t, _CMP_NLE_UQ);
+					result |= static_cast<std::uint32_t>(_mm256_movemask_ps(above)) << half;
+				}
+				return result & laneMask;
+			}
+
+			SPIKE_TARGET_AVX512
+			static std::uint32_t sweep_Avx512(const KernelTime * const endRefractoryPeriod, const Voltage * const voltage, const std::uint32_t laneMask, const KernelTime kerneltime, const float * const table, const KernelTime tableSize, const Voltage minimalThreshold, Voltage * const threshold)
+			{
+				__m512 t = _mm512_set1_ps(minimalThreshold);
+				for (size_t i = 0; i < 4; ++i)
+				{
+					const __m512i endTimes = _mm512_loadu_si512(endRefractoryPeriod + (i * blockSize));
+					const __m512i relativeTime = _mm512_sub_epi32(_mm512_set1_epi32(kerneltime), endTimes);
+					const __mmask16 inRange = _mm512_cmpge_epi32_mask(relativeTime, _mm512_setzero_si512())
+						& _mm512_cmplt_epi32_mask(relativeTime, _mm512_set1_epi32(tableSize));
+					const __m512 factor = _mm512_mask_i32gather_ps(_mm512_set1_ps(1.0f), inRange, relativeTime, table, 4);
+					t = _mm512_mul_ps(t, factor);
+				}
+				_mm512_storeu_ps(threshold, t);
+				const __mmask16 above = _mm512_cmp_ps_mask(_mm512_loadu_ps(voltage), t, _CMP_NLE_UQ);
+				return static_cast<std::uint32_t>(above) & laneMask;
+			}
+#endif
+
+		private:
+
+			SimdIsa isa_;
+			Function function_;
+
+			static Function getFunction(const SimdIsa isa)
+			{
+#if defined(SPIKE_SIMD_X86)
+				switch (isa)
+				{
+					case SimdIsa::AVX2: return &ThresholdSweep::sweep_Avx2;
+					case SimdIsa::AVX512: return &ThresholdSweep::sweep_Avx512;
+					default: break;
+				}
+#endif
+				return &ThresholdSweep::sweep_Scalar;
+			}
+		};
+	}
+}
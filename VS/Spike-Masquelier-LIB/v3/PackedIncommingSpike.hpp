@@ -0,0 +1,138 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <cmath>		// std::lround
+
+#include "../../Spike-Tools-LIB/assert.ipp"
+
+#include "Types.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// Incomming spike record of 8 bytes for the per destination buffers of IncommingSpikeStore, instead of the 20 bytes of
+		// IncommingSpike. The destination is implied by the buffer and the synapse is not needed by the voltage computation.
+		// - time: 14 bits, the offset in kernel time to a base time that is kept per destination by IncommingSpikeStore;
+		// - origin: 18 bits, at most 262144 neurons;
+		// - efficacy: int16 in steps of 2^-13, range [-4, 4).
+		// The time is exact. The efficacy is rounded to the nearest step: the error per spike is at most 2^-14 = 6.1e-5, hence the
+		// voltage error is at most 6.1e-5 * max epsilon * the number of incomming spikes in the epsilon kernel range (with max
+		// epsilon 1: 0.012 for 200 incomming spikes, against a threshold of at least 8).
+		struct PackedIncommingSpike
+		{
+			static const bool hasBaseTime = true;
+			static const int timeBits = 14;
+			static const std::uint32_t timeMask = (1u << timeBits) - 1;
+			static const KernelTime maxTimeOffset = static_cast<KernelTime>(timeMask);
+			static const NeuronId maxOrigin = (1u << (32 - timeBits)) - 1;
+			static constexpr float efficacyStep = 1.0f / 8192; // 2^-13, a power of two such that decoding is exact
+			static constexpr float maxEfficacy = 32767 * efficacyStep;
+
+			std::uint32_t timeAndOrigin;
+			std::int16_t efficacy;
+			std::uint16_t unused;
+
+			// default constructor
+			PackedIncommingSpike()
+				: timeAndOrigin(0)
+				, efficacy(0)
+				, unused(0)
+			{
+			}
+
+			// constructor: encode the provided spike with a time relative to the provided base time
+			PackedIncommingSpike(const IncommingSpike& spike, const KernelTime baseTime)
+				: timeAndOrigin(static_cast<std::uint32_t>(spike.kerneltime - baseTime) | (spike.origin << timeBits))
+				, efficacy(encodeEfficacy(spike.efficacy))
+				, unused(0)
+			{
+				::tools::assert::assert_msg((spike.kerneltime >= baseTime) && ((spike.kerneltime - baseTime) <= maxTimeOffset), "spike::v3::PackedIncommingSpike: time ", spike.kerneltime, " does not fit base time ", baseTime);
+				::tools::assert::assert_msg(spike.origin <= maxOrigin, "spike::v3::PackedIncommingSpike: origin ", spike.origin, " does not fit");
+			}
+
+			KernelTime getKernelTime(const KernelTime baseTime) const
+			{
+				return baseTime + static_cast<KernelTime>(this->timeAndOrigin & timeMask);
+			}
+
+			NeuronId getOrigin() const
+			{
+				return static_cast<NeuronId>(this->timeAndOrigin >> timeBits);
+			}
+
+			Efficacy getEfficacy() const
+			{
+				return static_cast<Efficacy>(this->efficacy) * efficacyStep;
+			}
+
+			// encode the time relative to a new base time, the spike has to fit the new base time
+			void rebase(const KernelTime oldBaseTime, const KernelTime newBaseTime)
+			{
+				const KernelTime kerneltime = this->getKernelTime(oldBaseTime);
+				this->timeAndOrigin = static_cast<std::uint32_t>(kerneltime - newBaseTime) | (this->timeAndOrigin & ~timeMask);
+			}
+
+			static std::int16_t encodeEfficacy(const Efficacy efficacy)
+			{
+				const long value = std::lround(efficacy / efficacyStep);
+				return static_cast<std::int16_t>((value > 32767) ? 32767 : ((value < -32768) ? -32768 : value));
+			}
+		};
+
+		static_assert(sizeof(PackedIncommingSpike) == 8, "PackedIncommingSpike has to be 8 bytes");
+
+		// encode the provided spike as record of the per destination buffers of IncommingSpikeStore
+		inline void encodeSpikeRecord(const IncommingSpike& spike, const KernelTime /*baseTime*/, IncommingSpike& record)
+		{
+			record = spike;
+		}
+
+		inline void encodeSpikeRecord(const IncommingSpike& spike, const KernelTime baseTime, PackedIncommingSpike& record)
+		{
+			record = PackedIncommingSpike(spike, baseTime);
+		}
+
+		// encode the time of the provided record relative to a new base time; the time of an IncommingSpike is absolute
+		inline void rebaseSpikeRecord(IncommingSpike& /*record*/, const KernelTime /*oldBaseTime*/, const KernelTime /*newBaseTime*/)
+		{
+		}
+
+		inline void rebaseSpikeRecord(PackedIncommingSpike& record, const KernelTime oldBaseTime, const KernelTime newBaseTime)
+		{
+			record.rebase(oldBaseTime, newBaseTime);
+		}
+
+		// shift the time of the provided record; the time of a PackedIncommingSpike is shifted with its base time
+		inline void substractTimeSpikeRecord(IncommingSpike& record, const KernelTime time)
+		{
+			record.kerneltime -= time;
+		}
+
+		inline void substractTimeSpikeRecord(PackedIncommingSpike& /*record*/, const KernelTime /*time*/)
+		{
+		}
+	}
+}
@@ -0,0 +1,184 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <utility>	// std::pair
+#include <cmath>
+#include <cstdlib>	// rand
+
+#include "Types.hpp"
+#include "SpikeOptionsStatic.hpp"
+#include "TimingWheel.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// Counter-based random numbers: the n-th number of a stream is a hash of (seed, stream, n), hence every stream is
+		// reproducible independent of the order in which the streams are used. The hash is the SplitMix64 finalizer.
+		class CounterBasedRandom
+		{
+		public:
+
+			static std::uint64_t hash(const std::uint64_t seed, const std::uint64_t stream, const std::uint64_t counter)
+			{
+				std::uint64_t z = seed + (stream * 0xD1B54A32D192ED03ULL) + ((counter + 1) * 0x9E3779B97F4A7C15ULL);
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+				return z ^ (z >> 31);
+			}
+
+			// return a uniform random number in (0, 1]
+			static double uniform(const std::uint64_t seed, const std::uint64_t stream, const std::uint64_t counter)
+			{
+				return static_cast<double>((hash(seed, stream, counter) >> 11) + 1) * (1.0 / 9007199254740992.0); // 2^53
+			}
+		};
+
+		// Schedule of the random (background) spikes of the neurons. Every neuron has one pending random spike; scheduling a new
+		// one cancels the previous one lazily: outdated entries are recognised and dropped when their window becomes due.
+		// The entries are kept in a timing wheel with one slot per minDelay window, such that advancing the time only touches
+		// the neurons whose random spike is in the new window.
+		template <typename Topology_i>
+		class RandomSpikeScheduler
+		{
+		public:
+
+			using Topology = Topology_i;
+			using Options = typename Topology_i::Options;
+
+			// constructor
+			RandomSpikeScheduler()
+				: schedule_(TimingWheel<std::pair<KernelTime, NeuronId>>(nSlots))
+				, nextWindow_(0)
+			{
+				this->clear();
+			}
+
+			// remove all random spikes and go back to time zero, the random streams restart; the allocated memory is retained
+			void clear()
+			{
+				this->schedule_.clear();
+				this->nextWindow_ = 0;
+				this->nextSpikeTime_.fill(NO_KERNEL_TIME);
+				this->counter_.fill(0);
+			}
+
+			// draw the random spike of the provided neuron after the provided time, and cancel its previous random spike
+			KernelTime scheduleNext(const NeuronId neuronId, const KernelTime time)
+			{
+				const double averageTimeBetweenSpikes = 2000.0 / Options::randomSpikeHz;
+				const double r = (Options::randomSpikeGenerator == RandomSpikeGenerator::COUNTER_BASED)
+					? CounterBasedRandom::uniform(Options::randomSeed, neuronId, this->counter_[neuronId]++)
+					: static_cast<double>(rand() + 1) / RAND_MAX;
+				const TimeInMs timeDelta = static_cast<TimeInMs>(averageTimeBetweenSpikes * r);
+
+				const KernelTime nextSpikeTime = (std::isfinite(timeDelta)) ? (time + Options::toKernelTime(timeDelta)) : (time + 1);
+				this->nextSpikeTime_[neuronId] = nextSpikeTime;
+
+				const KernelTime window = nextSpikeTime / windowSize;
+				::tools::assert::assert_msg(window >= this->nextWindow_, "spike::v3::RandomSpikeScheduler::scheduleNext: random spike time ", nextSpikeTime, " is in a window that has already passed");
+				this->schedule_.add(window, std::make_pair(nextSpikeTime, neuronId));
+				return nextSpikeTime;
+			}
+
+			KernelTime getNextSpikeTime(const NeuronId neuronId) const
+			{
+				return this->nextSpikeTime_[neuronId];
+			}
+
+			// call f(neuronId) for every neuron whose random spike has become due before futureTime; futureTime is the end of a window
+			template <typename F>
+			void advanceCurrentTime(const KernelTime futureTime, F f)
+			{
+				const KernelTime endWindow = futureTime / windowSize;
+				for (KernelTime window = this->nextWindow_; window < endWindow; ++window)
+				{
+					if (this->schedule_.empty()) break;
+					for (const std::pair<KernelTime, NeuronId>& entry : this->schedule_.getSlot(window))
+					{
+						if (entry.first == this->nextSpikeTime_[entry.second])
+						{
+							f(entry.second);
+						}
+					}
+					this->schedule_.clearSlot(window);
+				}
+				this->nextWindow_ = std::max(this->nextWindow_, endWindow);
+			}
+
+			// return the start of the first window with a pending random spike, LAST_KERNEL_TIME if there is none; cancelled
+			// entries are not recognised, hence the returned time can be earlier than the first actual random spike
+			KernelTime getNextSpikeTime() const
+			{
+				const KernelTime window = this->schedule_.getNextOccupiedTime(this->nextWindow_);
+				return (window == LAST_KERNEL_TIME) ? LAST_KERNEL_TIME : (window * windowSize);
+			}
+
+			void substractTime(const KernelTime time)
+			{
+				::tools::assert::assert_msg((time % windowSize) == 0, "spike::v3::RandomSpikeScheduler::substractTime: time ", time, " is not a multiple of the window size");
+
+				// the slot of an entry depends on its time: reschedule all pending entries
+				const std::vector<std::pair<KernelTime, NeuronId>> entries = this->schedule_.getAll();
+				this->schedule_.clear();
+				for (const std::pair<KernelTime, NeuronId>& entry : entries)
+				{
+					if (entry.first == this->nextSpikeTime_[entry.second])
+					{
+						const KernelTime newTime = entry.first - time;
+						this->schedule_.add(newTime / windowSize, std::make_pair(newTime, entry.second));
+					}
+				}
+				for (KernelTime& nextSpikeTime : this->nextSpikeTime_)
+				{
+					if (nextSpikeTime != NO_KERNEL_TIME) nextSpikeTime -= time;
+				}
+				this->nextWindow_ -= time / windowSize;
+			}
+
+			// return the number of bytes allocated
+			size_t getMemoryUsage() const
+			{
+				return sizeof(RandomSpikeScheduler) + this->schedule_.getMemoryUsage();
+			}
+
+		private:
+
+			static const KernelTime windowSize = Options::toKernelTime(static_cast<TimeInMs>(Options::minDelay));
+
+			// a random spike is at most 2000/randomSpikeHz ms after the time it is drawn, which is at most a refractory period after the current window
+			static const size_t nSlots = static_cast<size_t>(Options::toKernelTime((2000.0f / Options::randomSpikeHz) + Options::refractoryPeriod) / windowSize) + 3;
+
+			TimingWheel<std::pair<KernelTime, NeuronId>> schedule_;
+			KernelTime nextWindow_; // the first window that has not been advanced over
+
+			std::array<KernelTime, Options::nNeurons> nextSpikeTime_;
+			std::array<std::uint64_t, Options::nNeurons> counter_;
+		};
+	}
+}
@@ -0,0 +1,119 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <vector>
+#include <algorithm>	// std::remove_if
+
+#include "SpikeOptionsStatic.hpp"
+#include "Types.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// Per destination neuron the synapses over which a spike of an excitatory neuron has been scheduled, with the arrival time.
+		// Used by PlasticityEngine::RECENT_DELIVERIES: when a neuron fires, LTP only visits the synapses that delivered a spike
+		// in the last kernelRangeStdpInMs, instead of all incomming synapses. The deliveries are added when they are scheduled,
+		// like the last deliver time of the synapse, such that a spike that arrives at the fire time but is not yet in the queue
+		// counts as with PlasticityEngine::PAIR_SCAN. Deliveries that no fire can use anymore are removed when the buffer of a
+		// neuron is full, instead of growing it.
+		template <typename Topology_i>
+		class RecentDeliveries
+		{
+		public:
+
+			using Topology = Topology_i;
+			using Options = typename Topology_i::Options;
+
+			// constructor
+			RecentDeliveries()
+				: deliveries_(std::vector<std::vector<Delivery>>(Options::nNeurons))
+			{
+			}
+
+			void add(const NeuronId destination, const KernelTime kerneltime, const SynapseId synapseId)
+			{
+				std::vector<Delivery>& deliveries = this->deliveries_[destination];
+				if (deliveries.size() == deliveries.capacity())
+				{
+					// the provided arrival time is at most maxDelay + minDelay after the window in which the destination can fire next
+					const KernelTime timeHorizon = kerneltime - Options::toKernelTime(Options::kernelRangeStdpInMs + static_cast<TimeInMs>(Options::maxDelay + Options::minDelay));
+					deliveries.erase(std::remove_if(deliveries.begin(), deliveries.end(), [timeHorizon](const Delivery& delivery) { return delivery.kerneltime <= timeHorizon; }), deliveries.end());
+				}
+				deliveries.push_back(Delivery(kerneltime, synapseId));
+			}
+
+			// call f(synapseId, kerneltime) for every delivery to the provided destination after the provided time horizon
+			template <typename F>
+			void forEach(const NeuronId destination, const KernelTime timeHorizon, const F& f) const
+			{
+				for (const Delivery& delivery : this->deliveries_[destination])
+				{
+					if (delivery.kerneltime > timeHorizon)
+					{
+						f(delivery.synapseId, delivery.kerneltime);
+					}
+				}
+			}
+
+			void substractTime(const KernelTime time)
+			{
+				for (std::vector<Delivery>& deliveries : this->deliveries_)
+				{
+					for (Delivery& delivery : deliveries)
+					{
+						delivery.kerneltime -= time;
+					}
+				}
+			}
+
+			// return the number of bytes allocated
+			size_t getMemoryUsage() const
+			{
+				size_t result = this->deliveries_.capacity() * sizeof(std::vector<Delivery>);
+				for (const std::vector<Delivery>& deliveries : this->deliveries_)
+				{
+					result += deliveries.capacity() * sizeof(Delivery);
+				}
+				return result;
+			}
+
+		private:
+
+			struct Delivery
+			{
+				KernelTime kerneltime;
+				SynapseId synapseId;
+
+				Delivery(const KernelTime kerneltime, const SynapseId synapseId)
+					: kerneltime(kerneltime)
+					, synapseId(synapseId)
+				{
+				}
+			};
+
+			std::vector<std::vector<Delivery>> deliveries_;
+		};
+	}
+}
@@ -0,0 +1,129 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define SPIKE_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>		// __cpuidex, _xgetbv
+#else
+#include <cpuid.h>		// __get_cpuid_count
+#endif
+#endif
+
+// MSVC accepts all intrinsics in every function; gcc and clang need the instruction set per function
+#if defined(_MSC_VER) || !defined(SPIKE_SIMD_X86)
+#define SPIKE_TARGET_SSE41
+#define SPIKE_TARGET_AVX2
+#define SPIKE_TARGET_AVX512
+#else
+#define SPIKE_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SPIKE_TARGET_AVX2 __attribute__((target("avx2")))
+#define SPIKE_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+namespace spike
+{
+	namespace v3
+	{
+		// instruction sets of the SIMD kernels, selected at runtime
+		enum class SimdIsa : std::uint8_t
+		{
+			SCALAR = 0,
+			SSE41 = 1,
+			AVX2 = 2,
+			AVX512 = 3
+		};
+
+		inline const char * toString(const SimdIsa isa)
+		{
+			switch (isa)
+			{
+				case SimdIsa::SSE41: return "SSE4.1";
+				case SimdIsa::AVX2: return "AVX2";
+				case SimdIsa::AVX512: return "AVX-512";
+				default: return "scalar";
+			}
+		}
+
+		namespace priv
+		{
+#if defined(SPIKE_SIMD_X86)
+			inline void cpuid(int info[4], const int function, const int subfunction)
+			{
+#if defined(_MSC_VER)
+				__cpuidex(info, function, subfunction);
+#else
+				unsigned int a = 0, b = 0, c = 0, d = 0;
+				__get_cpuid_count(static_cast<unsigned int>(function), static_cast<unsigned int>(subfunction), &a, &b, &c, &d);
+				info[0] = static_cast<int>(a);
+				info[1] = static_cast<int>(b);
+				info[2] = static_cast<int>(c);
+				info[3] = static_cast<int>(d);
+#endif
+			}
+
+			inline std::uint64_t xgetbv()
+			{
+#if defined(_MSC_VER)
+				return _xgetbv(0);
+#else
+				unsigned int eax = 0, edx = 0;
+				__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+				return (static_cast<std::uint64_t>(edx) << 32) | eax;
+#endif
+			}
+#endif
+		}
+
+		// return the best instruction set that is supported by the cpu and the operating system
+		inline SimdIsa detectSimdIsa()
+		{
+#if defined(SPIKE_SIMD_X86)
+			int info1[4];
+			int info7[4];
+			priv::cpuid(info1, 1, 0);
+			priv::cpuid(info7, 7, 0);
+
+			const bool sse41 = (info1[2] & (1 << 19)) != 0;
+			const bool osxsave = (info1[2] & (1 << 27)) != 0;
+			const bool avx = (info1[2] & (1 << 28)) != 0;
+			const bool avx2 = (info7[1] & (1 << 5)) != 0;
+			const bool avx512f = (info7[1] & (1 << 16)) != 0;
+
+			// the operating system has to save the ymm (bits 1,2) and zmm (bits 5,6,7) registers
+			const std::uint64_t xcr0 = (osxsave) ? priv::xgetbv() : 0;
+			const bool osAvx = (xcr0 & 0x06) == 0x06;
+			const bool osAvx512 = (xcr0 & 0xE6) == 0xE6;
+
+			if (avx512f && osAvx512) return SimdIsa::AVX512;
+			if (avx && avx2 && osAvx) return SimdIsa::AVX2;
+			if (sse41) return SimdIsa::SSE41;
+#endif
+			return SimdIsa::SCALAR;
+		}
+	}
+}
@@ -25,6 +25,7 @@
 #include <vector>
 #include <array>
 #include <bitset>
+#include <algorithm>	// std::stable_sort
 
 #include "../../Spike-Tools-LIB/SpikeTypes.hpp"
 
@@ -60,6 +61,7 @@ namespace spike
 				, nNeurons_(neuronIds.size())
 				, areAllNeuronsRandom_(true)
 				, randomFireHz_(std::vector<float>(this->nNeurons_))
+				, eventsCompiled_(true)
 			{
 				if (this->nNeurons_ == 0)
 				{
@@ -82,6 +84,8 @@ namespace spike
 				, data_(other.data_)
 				, areAllNeuronsRandom_(other.areAllNeuronsRandom_)
 				, randomFireHz_(other.randomFireHz_)
+				, events_(std::move(other.events_))
+				, eventsCompiled_(other.eventsCompiled_)
 			{
 				//std::cout << "Variable::move ctor" << std::endl;
 			}
@@ -103,6 +107,8 @@ namespace spike
 				this->data_ = other.data_;
 				this->areAllNeuronsRandom_ = other.areAllNeuronsRandom_;
 				this->randomFireHz_ = std::move(other.randomFireHz_);
+				this->events_ = std::move(other.events_);
+				this->eventsCompiled_ = other.eventsCompiled_;
 
 				return *this;	// by convention, always return *this
 			}
@@ -110,6 +116,48 @@ namespace spike
 			void setSpikeTimes(const NeuronId neuronId, const std::vector<TimeInMs>& spikeTimes)
 			{
 				this->data_[neuronId] = spikeTimes;
+				this->eventsCompiled_ = false;
+			}
+
+			// merge the spike times of all neurons into one list of events sorted by window (minDelay), and within a window by
+			// neuronId and time: the order in which Network3 used to poll the sensor neurons. Call after the last setSpikeTimes.
+			void compileEvents()
+			{
+				this->events_.clear();
+				for (NeuronId neuronId = 0; neuronId < Options::nNeurons; ++neuronId)
+				{
+					std::vector<TimeInMs> spikeTimes = this->data_[neuronId];
+					std::sort(spikeTimes.begin(), spikeTimes.end());
+					for (const TimeInMs spikeTime : spikeTimes)
+					{
+						this->events_.push_back(SensorEvent(Options::toKernelTime(spikeTime), neuronId));
+					}
+				}
+				SpikeCase::sortEvents(this->events_.begin(), this->events_.end());
+				this->events_.shrink_to_fit();
+				this->eventsCompiled_ = true;
+			}
+
+			// sort events that are in neuronId and time order by window, keeping that order within a window
+			template <typename It>
+			static void sortEvents(const It begin, const It end)
+			{
+				const KernelTime windowSize = std::max<KernelTime>(1, Options::toKernelTime(static_cast<TimeInMs>(Options::minDelay)));
+				std::stable_sort(begin, end, [windowSize](const SensorEvent& a, const SensorEvent& b)
+				{
+					return (a.offset / windowSize) < (b.offset / windowSize);
+				});
+			}
+
+			// the events made by compileEvents, with times relative to the start of the case
+			const std::vector<SensorEvent>& getEvents() const
+			{
+				return this->events_;
+			}
+
+			bool areEventsCompiled() const
+			{
+				return this->eventsCompiled_;
 			}
 
 			void setRandomSpikeHz(const NeuronId neuronId, const float spikeHz)
@@ -205,6 +253,8 @@ namespace spike
 				{
 					this->data_[i].clear();
 				}
+				this->events_.clear();
+				this->eventsCompiled_ = true;
 			}
 
 			std::string toString() const
@@ -252,6 +302,9 @@ namespace spike
 			// store which neuronIds contain random content; if this field is set to zero this indicates that the neuron is not random but with case data
 			std::vector<float> randomFireHz_;
 
+			// the spike times of all neurons sorted by window, see compileEvents
+			std::vector<SensorEvent> events_;
+			bool eventsCompiled_;
 		};
 	}
 }
\ No newline at end of file
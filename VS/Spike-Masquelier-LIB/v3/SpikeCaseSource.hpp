@@ -0,0 +1,62 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <vector>
+
+#include "../../Spike-Tools-LIB/SpikeTypes.hpp"
+
+#include "Types.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// the events of one case; the neuronId of an event is the neuronId in the case (e.g. the pixel index), offsets in kernel time
+		struct EncodedCase
+		{
+			CaseId caseId;
+			CaseLabel caseLabel;
+			std::vector<SensorEvent> events; // in neuronId and time order
+		};
+
+		// Online source of regular cases for SpikeStreamDataSet, see SpikeStreamDataSet::setCaseSource; e.g. MnistSpikeSource.
+		class SpikeCaseSource
+		{
+		public:
+
+			// destructor
+			virtual ~SpikeCaseSource() = default;
+
+			// start producing cases; subsequent calls have no effect
+			virtual void start() = 0;
+
+			// move the next case into the provided case; return false when the source has stopped
+			virtual bool next(EncodedCase& encodedCase) = 0;
+
+			// the duration of every case, larger than zero
+			virtual TimeInMs getCaseDurationInMs() const = 0;
+		};
+	}
+}
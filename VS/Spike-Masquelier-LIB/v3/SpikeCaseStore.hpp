@@ -0,0 +1,324 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <vector>
+#include <memory>		// std::shared_ptr
+#include <limits>		// std::numeric_limits
+#include <algorithm>	// std::sort
+
+#include "../../Spike-Tools-LIB/SpikeTypes.hpp"
+
+#include "Types.hpp"
+#include "SpikeOptionsStatic.hpp"
+#include "SpikeCase.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// Flat store of the regular cases of a spike stream. The events (see SpikeCase::compileEvents) of all cases are kept in
+		// one contiguous arena, a case is a compact record with the range of its events. The random fire rates of the neurons
+		// are kept as shared profiles: the cases of a data set only differ in the rate of the correct motor neuron, hence there
+		// are about as many profiles as labels. A SpikeCase needs a vector per neuron; this store needs no allocation per case.
+		template <typename Options_i>
+		class SpikeCaseStore
+		{
+		public:
+
+			using Options = Options_i;
+
+			struct CaseRecord
+			{
+				CaseId caseId;
+				CaseLabel caseLabel;
+				unsigned int profile; // index of the random fire rates, see getRandomFireHz
+				TimeInMs duration;
+				TimeInMs tailSilence;
+				unsigned int eventsBegin; // range [eventsBegin, eventsEnd) in the arena
+				unsigned int eventsEnd;
+
+				TimeInMs getDurationPlusSilence() const
+				{
+					return this->duration + this->tailSilence;
+				}
+			};
+
+			static const unsigned int NO_INDEX = std::numeric_limits<unsigned int>::max();
+
+			// constructor
+			SpikeCaseStore()
+				: eventsBegin_(0)
+				, externalEvents_(nullptr)
+				, nExternalEvents_(0)
+			{
+			}
+
+			void clear()
+			{
+				this->events_.clear();
+				this->cases_.clear();
+				this->indexOfCaseId_.clear();
+				this->profiles_.clear();
+				this->eventsBegin_ = 0;
+				this->externalEvents_ = nullptr;
+				this->nExternalEvents_ = 0;
+				this->externalOwner_.reset();
+			}
+
+			// remove the cases but keep the profiles and the allocated memory, e.g. to replace the case of an online source
+			void clearCases()
+			{
+				for (const CaseRecord& record : this->cases_)
+				{
+					this->indexOfCaseId_[record.caseId.val] = NO_INDEX;
+				}
+				this->events_.clear();
+				this->cases_.clear();
+				this->eventsBegin_ = 0;
+				this->externalEvents_ = nullptr;
+				this->nExternalEvents_ = 0;
+				this->externalOwner_.reset();
+			}
+
+			void reserve(const size_t nCases, const size_t nEvents)
+			{
+				this->cases_.reserve(nCases);
+				this->events_.reserve(nEvents);
+			}
+
+			// return the index of the provided random fire rates (one per neuron), add them when no equal profile exists
+			unsigned int addProfile(const std::vector<float>& randomFireHz)
+			{
+				::tools::assert::assert_msg(randomFireHz.size() == Options::nNeurons, "spike::v3::SpikeCaseStore::addProfile: expected one rate per neuron");
+				for (unsigned int i = 0; i < this->profiles_.size(); ++i)
+				{
+					if (this->profiles_[i] == randomFireHz) return i;
+				}
+				this->profiles_.push_back(randomFireHz);
+				return static_cast<unsigned int>(this->profiles_.size() - 1);
+			}
+
+			// use the provided events, e.g. a memory mapped file, as arena instead of copying them; owner keeps them alive. The
+			// cases are added with addExternalCase; the other ways of adding a case are not allowed while the arena is external
+			void setExternalEvents(const SensorEvent * const events, const size_t nEvents, const std::shared_ptr<const void>& owner)
+			{
+				this->clearCases();
+				::tools::assert::assert_msg(nEvents < NO_INDEX, "spike::v3::SpikeCaseStore::setExternalEvents: too many events");
+				this->externalEvents_ = events;
+				this->nExternalEvents_ = nEvents;
+				this->externalOwner_ = owner;
+			}
+
+			// add a case of which the events [eventsBegin, eventsEnd) are in the external arena, see setExternalEvents
+			void addExternalCase(const CaseId caseId, const CaseLabel caseLabel, const TimeInMs duration, const TimeInMs tailSilence, const unsigned int profile, const unsigned int eventsBegin, const unsigned int eventsEnd)
+			{
+				::tools::assert::assert_msg(this->externalEvents_ != nullptr, "spike::v3::SpikeCaseStore::addExternalCase: no external events");
+				::tools::assert::assert_msg((eventsBegin <= eventsEnd) && (eventsEnd <= this->nExternalEvents_), "spike::v3::SpikeCaseStore::addExternalCase: invalid event range of case ", caseId.val);
+				this->addRecord(caseId, caseLabel, duration, tailSilence, profile, eventsBegin, eventsEnd);
+			}
+
+			// append the spike times of one neuron to the case that is being added; a case is added with addSpikeTimes for each
+			// of its neurons in neuronId order, followed by endCase
+			void addSpikeTimes(const NeuronId neuronId, const std::vector<TimeInMs>& spikeTimes)
+			{
+				const size_t begin = this->events_.size();
+				for (const TimeInMs spikeTime : spikeTimes)
+				{
+					this->events_.push_back(SensorEvent(Options::toKernelTime(spikeTime), neuronId));
+				}
+				std::sort(this->events_.begin() + begin, this->events_.end(), [](const SensorEvent& a, const SensorEvent& b) { return a.offset < b.offset; });
+			}
+
+			// append one event to the case that is being added; the events of a case are added in neuronId and time order
+			void addEvent(const SensorEvent event)
+			{
+				this->events_.push_back(event);
+			}
+
+			// close the case that is being added
+			void endCase(const CaseId caseId, const CaseLabel caseLabel, const TimeInMs duration, const TimeInMs tailSilence, const unsigned int profile)
+			{
+				::tools::assert::assert_msg(this->externalEvents_ == nullptr, "spike::v3::SpikeCaseStore::endCase: the arena is external");
+				::tools::assert::assert_msg(this->events_.size() < NO_INDEX, "spike::v3::SpikeCaseStore::endCase: too many events");
+
+				SpikeCase<Options>::sortEvents(this->events_.begin() + this->eventsBegin_, this->events_.end());
+
+				this->addRecord(caseId, caseLabel, duration, tailSilence, profile, this->eventsBegin_, static_cast<unsigned int>(this->events_.size()));
+				this->eventsBegin_ = static_cast<unsigned int>(this->events_.size());
+			}
+
+			// add a copy of the provided (regular) case
+			void add(const SpikeCase<Options>& spikeCase)
+			{
+				std::vector<float> randomFireHz(Options::nNeurons, 0.0f);
+				for (const NeuronId neuronId : spikeCase.getNeuronIds())
+				{
+					randomFireHz[neuronId] = spikeCase.getRandomFireHz(neuronId);
+				}
+				for (NeuronId neuronId = 0; neuronId < Options::nNeurons; ++neuronId)
+				{
+					this->addSpikeTimes(neuronId, spikeCase.getSpikeTimes(neuronId));
+				}
+				this->endCase(spikeCase.getCaseId(), spikeCase.getCaseLabel(), spikeCase.getDuration(), spikeCase.getDurationPlusSilence() - spikeCase.getDuration(), this->addProfile(randomFireHz));
+			}
+
+			// add a copy of the case with the provided id of another store
+			void add(const SpikeCaseStore& other, const CaseId caseId)
+			{
+				const unsigned int index = other.getIndex(caseId);
+				const CaseRecord& record = other.getCase(index);
+				const SensorEvent * const events = other.getEvents(index);
+				this->events_.insert(this->events_.end(), events, events + (record.eventsEnd - record.eventsBegin));
+				this->endCase(record.caseId, record.caseLabel, record.duration, record.tailSilence, this->addProfile(other.getRandomFireHz(record.profile)));
+			}
+
+			size_t getNumberOfCases() const
+			{
+				return this->cases_.size();
+			}
+
+			size_t getNumberOfEvents() const
+			{
+				return (this->externalEvents_ != nullptr) ? this->nExternalEvents_ : this->events_.size();
+			}
+
+			bool hasCaseId(const CaseId caseId) const
+			{
+				return (caseId.val < this->indexOfCaseId_.size()) && (this->indexOfCaseId_[caseId.val] != NO_INDEX);
+			}
+
+			// return the position of the case with the provided id, in order of adding; NO_INDEX if there is no such case
+			unsigned int getIndex(const CaseId caseId) const
+			{
+				return (this->hasCaseId(caseId)) ? this->indexOfCaseId_[caseId.val] : NO_INDEX;
+			}
+
+			const CaseRecord& getCase(const size_t index) const
+			{
+				return this->cases_[index];
+			}
+
+			// return the first event of the case at the provided position; the case has getCase(index).eventsEnd - eventsBegin events
+			const SensorEvent * getEvents(const size_t index) const
+			{
+				return this->getArena() + this->cases_[index].eventsBegin;
+			}
+
+			const std::vector<float>& getRandomFireHz(const unsigned int profile) const
+			{
+				return this->profiles_[profile];
+			}
+
+			std::vector<CaseId> getCaseIds() const
+			{
+				std::vector<CaseId> caseIds;
+				caseIds.reserve(this->cases_.size());
+				for (const CaseRecord& record : this->cases_)
+				{
+					caseIds.push_back(record.caseId);
+				}
+				return caseIds;
+			}
+
+			// return a SpikeCase with the content of the case at the provided position; the spike times are rounded to kernel time
+			std::shared_ptr<const SpikeCase<Options>> toSpikeCase(const size_t index, const std::vector<NeuronId>& neuronIds) const
+			{
+				const CaseRecord& record = this->cases_[index];
+				const auto spikeCase = std::make_shared<SpikeCase<Options>>(SpikeCase<Options>(record.caseId, record.caseLabel, neuronIds, record.duration, record.tailSilence));
+
+				std::vector<std::vector<TimeInMs>> spikeTimes(Options::nNeurons);
+				const SensorEvent * const arena = this->getArena();
+				for (unsigned int i = record.eventsBegin; i < record.eventsEnd; ++i)
+				{
+					spikeTimes[arena[i].neuronId].push_back(Options::toTimeInMs(arena[i].offset));
+				}
+				const std::vector<float>& randomFireHz = this->profiles_[record.profile];
+				for (const NeuronId neuronId : neuronIds)
+				{
+					spikeCase->setRandomSpikeHz(neuronId, randomFireHz[neuronId]);
+					spikeCase->setSpikeTimes(neuronId, spikeTimes[neuronId]);
+				}
+				spikeCase->compileEvents();
+				return spikeCase;
+			}
+
+			// return the number of bytes allocated; an external arena is not included
+			size_t getMemoryUsage() const
+			{
+				size_t result = (this->events_.capacity() * sizeof(SensorEvent))
+					+ (this->cases_.capacity() * sizeof(CaseRecord))
+					+ (this->indexOfCaseId_.capacity() * sizeof(unsigned int));
+				for (const std::vector<float>& profile : this->profiles_)
+				{
+					result += profile.capacity() * sizeof(float);
+				}
+				return result;
+			}
+
+		private:
+
+			std::vector<SensorEvent> events_; // the events of all cases, per case sorted as in SpikeCase::compileEvents
+			std::vector<CaseRecord> cases_;
+			std::vector<unsigned int> indexOfCaseId_; // position in cases_ of a caseId, NO_INDEX if absent
+			std::vector<std::vector<float>> profiles_; // random fire rates in Hz, one per neuron
+
+			unsigned int eventsBegin_; // first event of the case that is being added
+
+			// external arena, see setExternalEvents; nullptr if the arena is events_
+			const SensorEvent * externalEvents_;
+			size_t nExternalEvents_;
+			std::shared_ptr<const void> externalOwner_;
+
+			const SensorEvent * getArena() const
+			{
+				return (this->externalEvents_ != nullptr) ? this->externalEvents_ : this->events_.data();
+			}
+
+			void addRecord(const CaseId caseId, const CaseLabel caseLabel, const TimeInMs duration, const TimeInMs tailSilence, const unsigned int profile, const unsigned int eventsBegin, const unsigned int eventsEnd)
+			{
+				::tools::assert::assert_msg(!this->hasCaseId(caseId), "spike::v3::SpikeCaseStore::addRecord: caseId ", caseId.val, " is already present");
+				::tools::assert::assert_msg(profile < this->profiles_.size(), "spike::v3::SpikeCaseStore::addRecord: invalid profile ", profile);
+
+				CaseRecord record;
+				record.caseId = caseId;
+				record.caseLabel = caseLabel;
+				record.profile = profile;
+				record.duration = duration;
+				record.tailSilence = tailSilence;
+				record.eventsBegin = eventsBegin;
+				record.eventsEnd = eventsEnd;
+
+				if (this->indexOfCaseId_.size() <= caseId.val)
+				{
+					this->indexOfCaseId_.resize(static_cast<size_t>(caseId.val) + 1, NO_INDEX);
+				}
+				this->indexOfCaseId_[caseId.val] = static_cast<unsigned int>(this->cases_.size());
+				this->cases_.push_back(record);
+			}
+		};
+
+		template <typename Options_i>
+		const unsigned int SpikeCaseStore<Options_i>::NO_INDEX;
+	}
+}
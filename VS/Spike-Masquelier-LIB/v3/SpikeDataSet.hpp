@@ -61,7 +61,7 @@ namespace spike
 				this->clear();
 				//std::cout << "SpikeDataSetState::init: going to add " << neuronIds.size() << " neurons." <<std::endl;
 
-				this->neuronIds_.resize(nNeurons);
+				this->neuronIds_.reserve(nNeurons);
 				this->caseDuration_.resize(nCases);
 				this->data_.resize(nCases);
 
@@ -138,7 +138,7 @@ namespace spike
 				const size_t nSpikes = this->data_[caseId.val][neuronId].size();
 				if (nSpikes > 0)
 				{
-					if (this->data_[caseId.val][neuronId][nSpikes - 1] >= this->data_[caseId.val][neuronId][nSpikes])
+					if (this->data_[caseId.val][neuronId][nSpikes - 1] >= spikeTime)
 					{
 						std::cout << "spike::v3::addSpikesTime:addSpikeTime: provided spikeTime " << spikeTime << " is not in temporal order" << std::endl;
 						__debugbreak();
@@ -404,7 +404,7 @@ namespace spike
 					const size_t nNeurons = static_cast<size_t>(::tools::file::string2int(content1[1]));
 					const size_t nSpikes = static_cast<size_t>(::tools::file::string2int(content1[2]));
 
-					this->init(nCases, nNeurons);
+					this->init(nNeurons, nCases);
 
 					//3] load the case data
 					for (size_t i = 0; i < nCases; ++i)
@@ -425,8 +425,6 @@ namespace spike
 						this->setCaseDuration(caseId, caseDurationInMs);
 					}
 
-					this->init(nNeurons, nCases);
-
 					//4] handle neuron data
 					for (size_t i = 0; i < (nNeurons * nCases); ++i)
 					{
@@ -0,0 +1,273 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>		// std::shared_ptr
+#include <fstream>
+#include <iostream>		// std::cout, std::cerr
+#include <stdexcept>	// std::runtime_error
+#include <cstdint>		// std::uint32_t, std::uint64_t
+#include <cstring>		// std::memcmp, std::memcpy
+#include <algorithm>	// std::max
+#include <type_traits>	// std::is_trivially_copyable
+
+#include "../../Spike-Tools-LIB/SpikeTypes.hpp"
+#include "../../Spike-Tools-LIB/MappedFile.hpp"
+#include "../../Spike-Tools-LIB/file.ipp"
+
+#include "Types.hpp"
+#include "SpikeOptionsStatic.hpp"
+#include "SpikeCaseStore.hpp"
+#include "SpikeDataSet.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// Read-only binary spike data set in a memory mapped file: a header, an index with the label, duration and event range
+		// of every case, and one flat array with the events of all cases. The events are stored exactly as in the arena of
+		// SpikeCaseStore (sensor neuron ids of Topology, offsets in kernel time, per case sorted by window), such that
+		// SpikeStreamDataSet::addSpikeDataSet uses the mapped events without copying them and processes that open the same file
+		// share one copy in the page cache. The file is in the native byte order and is only valid for a Topology with the same
+		// sensor neurons, nSubMs and minDelay; use convert or convertFromTextFile to (re)create it from a SpikeDataSet.
+		template <typename Topology_i>
+		class SpikeDataSetBinary
+		{
+		public:
+
+			using Topology = Topology_i;
+			using Options = typename Topology_i::Options;
+
+			static const std::uint32_t currentVersion = 1;
+			static const std::uint32_t byteOrderMark = 0x01020304;
+
+			struct Header
+			{
+				char magic[8]; // "SPIKEDS"
+				std::uint32_t version;
+				std::uint32_t headerSize;
+				std::uint32_t byteOrderMark;
+				std::uint32_t nSubMs;
+				std::uint32_t windowSize; // in kernel time, the events of a case are sorted by offset / windowSize
+				std::uint32_t sensorNeuronBase; // Topology::Ns_start
+				std::uint32_t nSensorNeurons;
+				std::uint32_t nCases;
+				std::uint64_t nEvents;
+				std::uint64_t casesOffset; // in bytes from the start of the file
+				std::uint64_t eventsOffset;
+			};
+
+			struct CaseEntry
+			{
+				CaseIdType caseId;
+				CaseLabelType caseLabel;
+				float durationInMs;
+				std::uint32_t eventsBegin; // range [eventsBegin, eventsEnd) in the events
+				std::uint32_t eventsEnd;
+			};
+
+			// constructor: map the provided binary file
+			SpikeDataSetBinary(const std::string& filename)
+				: file_(std::make_shared<::spike::tools::MappedFile>(filename))
+			{
+				if (this->file_->size() < sizeof(Header))
+				{
+					std::cerr << "spike::v3::SpikeDataSetBinary: file " << filename << " is too small to be a binary spike data set" << std::endl;
+					throw std::runtime_error("invalid binary spike data set");
+				}
+				const Header& header = this->getHeader();
+				if (std::memcmp(header.magic, magic, sizeof(header.magic)) != 0)
+				{
+					std::cerr << "spike::v3::SpikeDataSetBinary: file " << filename << " is not a binary spike data set" << std::endl;
+					throw std::runtime_error("invalid binary spike data set");
+				}
+				if ((header.version != currentVersion) || (header.headerSize != sizeof(Header)) || (header.byteOrderMark != byteOrderMark))
+				{
+					std::cerr << "spike::v3::SpikeDataSetBinary: file " << filename << " has version " << header.version << " or another byte order or layout than version " << currentVersion << " of this build; convert the text data set again" << std::endl;
+					throw std::runtime_error("unsupported binary spike data set");
+				}
+				if ((header.nSubMs != Options::nSubMs) || (header.windowSize != getWindowSize()) || (header.sensorNeuronBase != Topology::Ns_start) || (header.nSensorNeurons != Topology::Ns))
+				{
+					std::cerr << "spike::v3::SpikeDataSetBinary: file " << filename << " has been made for another topology or time resolution (nSubMs " << header.nSubMs << "; windowSize " << header.windowSize << "; sensor neurons " << header.nSensorNeurons << " from " << header.sensorNeuronBase << "); convert the text data set again" << std::endl;
+					throw std::runtime_error("incompatible binary spike data set");
+				}
+				if ((header.casesOffset % alignof(CaseEntry) != 0) || (header.eventsOffset % alignof(SensorEvent) != 0) ||
+					(header.casesOffset + (static_cast<std::uint64_t>(header.nCases) * sizeof(CaseEntry)) > this->file_->size()) ||
+					(header.eventsOffset + (header.nEvents * sizeof(SensorEvent)) > this->file_->size()) ||
+					(header.nEvents >= SpikeCaseStore<Options>::NO_INDEX))
+				{
+					std::cerr << "spike::v3::SpikeDataSetBinary: file " << filename << " is truncated or corrupt" << std::endl;
+					throw std::runtime_error("invalid binary spike data set");
+				}
+				for (size_t i = 0; i < this->getNumberOfCases(); ++i)
+				{
+					const CaseEntry& entry = this->getCase(i);
+					if ((entry.eventsBegin > entry.eventsEnd) || (entry.eventsEnd > header.nEvents))
+					{
+						std::cerr << "spike::v3::SpikeDataSetBinary: file " << filename << " has an invalid event range for case " << entry.caseId << std::endl;
+						throw std::runtime_error("invalid binary spike data set");
+					}
+				}
+			}
+
+			size_t getNumberOfCases() const
+			{
+				return this->getHeader().nCases;
+			}
+
+			const CaseEntry& getCase(const size_t index) const
+			{
+				return reinterpret_cast<const CaseEntry *>(this->file_->data() + this->getHeader().casesOffset)[index];
+			}
+
+			size_t getNumberOfEvents() const
+			{
+				return static_cast<size_t>(this->getHeader().nEvents);
+			}
+
+			// the events of all cases, in the mapped file
+			const SensorEvent * getEvents() const
+			{
+				return reinterpret_cast<const SensorEvent *>(this->file_->data() + this->getHeader().eventsOffset);
+			}
+
+			// return the number of bytes mapped
+			size_t getFileSize() const
+			{
+				return this->file_->size();
+			}
+
+			// write the cases of the provided data set as binary spike data set
+			template <typename D>
+			static void convert(const SpikeDataSet<Options, D>& spikeDataSet, const std::string& filename)
+			{
+				//1] encode the cases as in SpikeStreamDataSet::addSpikeDataSet; the random fire rates are not stored
+				SpikeCaseStore<Options> store;
+				const unsigned int profile = store.addProfile(std::vector<float>(Options::nNeurons, 0.0f));
+				for (const CaseId& caseId : spikeDataSet.getCaseIds())
+				{
+					for (const NeuronId& neuronId : spikeDataSet.getNeuronIds())
+					{
+						store.addSpikeTimes(Topology::translateToSensorNeuronId(neuronId), spikeDataSet.getSpikeTimes(caseId, neuronId));
+					}
+					store.endCase(caseId, spikeDataSet.getClassificationLabel(caseId), spikeDataSet.getCaseDuration(caseId), 0, profile);
+				}
+
+				//2] layout: header, case index, events
+				Header header;
+				std::memset(&header, 0, sizeof(Header));
+				std::memcpy(header.magic, magic, sizeof(header.magic));
+				header.version = currentVersion;
+				header.headerSize = sizeof(Header);
+				header.byteOrderMark = byteOrderMark;
+				header.nSubMs = Options::nSubMs;
+				header.windowSize = getWindowSize();
+				header.sensorNeuronBase = static_cast<std::uint32_t>(Topology::Ns_start);
+				header.nSensorNeurons = static_cast<std::uint32_t>(Topology::Ns);
+				header.nCases = static_cast<std::uint32_t>(store.getNumberOfCases());
+				header.nEvents = store.getNumberOfEvents();
+				header.casesOffset = alignUp(sizeof(Header));
+				header.eventsOffset = alignUp(header.casesOffset + (header.nCases * sizeof(CaseEntry)));
+
+				std::vector<CaseEntry> entries(store.getNumberOfCases());
+				for (size_t index = 0; index < store.getNumberOfCases(); ++index)
+				{
+					const typename SpikeCaseStore<Options>::CaseRecord& record = store.getCase(index);
+					entries[index].caseId = record.caseId.val;
+					entries[index].caseLabel = record.caseLabel.val;
+					entries[index].durationInMs = record.duration;
+					entries[index].eventsBegin = record.eventsBegin;
+					entries[index].eventsEnd = record.eventsEnd;
+				}
+
+				//3] write
+				const std::string tree = ::tools::file::getDirectory(filename);
+				if (!::tools::file::mkdirTree(tree))
+				{
+					std::cerr << "spike::v3::SpikeDataSetBinary::convert: Unable to create directory " << tree << std::endl;
+					throw std::runtime_error("unable to create directory");
+				}
+				std::ofstream outputFile(filename, std::ios::binary | std::ios::trunc);
+				if (!outputFile.is_open())
+				{
+					std::cerr << "spike::v3::SpikeDataSetBinary::convert: Unable to open file " << filename << std::endl;
+					throw std::runtime_error("unable to open file");
+				}
+				const char padding[alignment] = {};
+				outputFile.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+				outputFile.write(padding, static_cast<std::streamsize>(header.casesOffset - sizeof(Header)));
+				outputFile.write(reinterpret_cast<const char *>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(CaseEntry)));
+				outputFile.write(padding, static_cast<std::streamsize>(header.eventsOffset - header.casesOffset - (entries.size() * sizeof(CaseEntry))));
+				if (header.nEvents > 0)
+				{
+					outputFile.write(reinterpret_cast<const char *>(store.getEvents(0)), static_cast<std::streamsize>(header.nEvents * sizeof(SensorEvent)));
+				}
+				if (!outputFile.good())
+				{
+					std::cerr << "spike::v3::SpikeDataSetBinary::convert: Unable to write file " << filename << std::endl;
+					throw std::runtime_error("unable to write file");
+				}
+				std::cout << "spike::v3::SpikeDataSetBinary::convert: wrote " << header.nCases << " cases with " << header.nEvents << " spikes to " << filename << std::endl;
+			}
+
+			// convert a data set in the text format of SpikeDataSet::saveToFile
+			static void convertFromTextFile(const std::string& textFilename, const std::string& binaryFilename)
+			{
+				SpikeDataSet<Options> spikeDataSet;
+				spikeDataSet.loadFromFile(textFilename);
+				convert(spikeDataSet, binaryFilename);
+			}
+
+		private:
+
+			static constexpr char magic[8] = {'S', 'P', 'I', 'K', 'E', 'D', 'S', '\0'};
+			static const size_t alignment = 8;
+
+			static_assert(sizeof(SensorEvent) == 8, "SensorEvent is stored as is in the file");
+			static_assert(std::is_trivially_copyable<SensorEvent>::value && std::is_trivially_copyable<CaseEntry>::value, "records are stored as is in the file");
+			static_assert(sizeof(Header) % alignment == 0, "the header is padded");
+
+			std::shared_ptr<const ::spike::tools::MappedFile> file_;
+
+			const Header& getHeader() const
+			{
+				return *reinterpret_cast<const Header *>(this->file_->data());
+			}
+
+			static std::uint32_t getWindowSize()
+			{
+				return static_cast<std::uint32_t>(std::max<KernelTime>(1, Options::toKernelTime(static_cast<TimeInMs>(Options::minDelay))));
+			}
+
+			static std::uint64_t alignUp(const std::uint64_t offset)
+			{
+				return ((offset + alignment - 1) / alignment) * alignment;
+			}
+		};
+
+		template <typename Topology_i>
+		constexpr char SpikeDataSetBinary<Topology_i>::magic[8];
+	}
+}
@@ -47,6 +47,8 @@ namespace spike
 
 			// misc options
 			static constexpr float randomSpikeHz = 1.0f;
+			static const RandomSpikeGenerator randomSpikeGenerator = RandomSpikeGenerator::GLOBAL_RAND;
+			static const unsigned long long randomSeed = 123456789; // seed of the per neuron random streams of RandomSpikeGenerator::COUNTER_BASED
 			static constexpr float trainRate = 0.005f;
 			static constexpr float refractoryPeriod = 5.0; // refractory period has to be larger than the smallest delay
 
@@ -81,6 +83,24 @@ namespace spike
 			static const bool useOpenMP = false;
 			static const int maxNumberOfThreads = 4;
 
+			// reporting options
+			static const bool printStatistics = false; // print the counters of the neuron tests, threshold solver and spike delivery with the progress of every simulated second
+
+			// neuron state options; to select another engine, derive from this class and hide the member
+			static const VoltageEngine voltageEngine = VoltageEngine::TABLE_SUM;
+			static const bool checkVoltageEngine = false; // compare the voltage of the selected engine with the exact kernel sum and report the max deviation
+			static const PlasticityEngine plasticityEngine = PlasticityEngine::PAIR_SCAN;
+			static const bool useVoltageUpperBound = false; // skip the threshold search of neurons whose voltage cannot reach the threshold
+			static const bool useActiveNeuronSet = false; // only test neurons with incomming spikes or a random spike in the current window
+			static const bool skipSilentWindows = false; // jump over windows in which no neuron can fire; requires useActiveNeuronSet and useVoltageUpperBound
+			static const bool useThresholdSweep = false; // compare voltage and threshold at the end of the window of a block of neurons at once, see NeuronStateBlocks
+			static const bool axonalFanOut = false; // a firing neuron schedules one event per delay group of its outgoing synapses, expanded into incomming spikes when due, see AxonalEventQueue
+			static const bool deferWeightUpdates = false; // accumulate the LTP and LTD changes per synapse and apply them every weightFlushIntervalInMs, see Synapses::flushWeightDeltas
+			static constexpr TimeInMs weightFlushIntervalInMs = 1.0f; // used by deferWeightUpdates; the weights are flushed at the end of a window (minDelay)
+			static const DecisionPolicy decisionPolicy = DecisionPolicy::NONE; // end the presentation of a case when a motor neuron has won, see Network3::getDecision; NONE: an early decision costs precision, see testNetworkV3_decisionPolicyBenchmark
+			static const unsigned int decisionSpikes = 1; // the number of spikes, or the margin, of the decision policy; a motor neuron rarely fires more than once in a case, a larger value seldom decides early
+			static const bool inferenceOnly = false; // evaluate a trained network: no LTD, no LTP and no last deliver times of the synapses; the weights are read-only
+
 
 			static const bool tranceNeuronOn = false;
 			static const NeuronId tranceNeuron = 116;
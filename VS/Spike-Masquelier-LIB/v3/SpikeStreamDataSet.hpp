@@ -29,13 +29,18 @@
 #include <array>
 #include <map>
 #include <bitset>
+#include <algorithm>	// for std::min
+#include <chrono>		// std::chrono::steady_clock
 
 #include "../../Spike-Tools-LIB/SpikeRuntimeOptions.hpp"
 #include "../../Spike-DataSet-LIB/SpikeSetLarge.hpp"
 #include "../../Spike-DataSet-LIB/Translations.hpp"
 
 #include "SpikeCase.hpp"
+#include "SpikeCaseStore.hpp"
+#include "SpikeCaseSource.hpp"
 #include "SpikeDataSet.hpp"
+#include "SpikeDataSetBinary.hpp"
 #include "Types.hpp"
 
 namespace spike
@@ -66,13 +71,16 @@ namespace spike
 				, currentCaseCounter_(0)
 				, currentCaseLabel_(NO_CASE_LABEL)
 				, currentCaseStartTime_(0)
+				, durationCurrentCase_(0)
+				, currentCaseIndex_(RANDOM_CASE)
 			{
 				this->randInt_ = static_cast<unsigned int>(rand());
 				this->randomSpikeHz_.fill(-1);
 				this->randomSpikeHzInteger_.fill(0);
 				this->nextRandomSpikeTime_.fill(std::numeric_limits<int>::max());
-				this->nextSpikeTime_.fill(LAST_KERNEL_TIME);
-				this->nextSpikeIndex_.fill(0);
+				this->nextEventIndex_ = 0;
+				this->nEvents_ = 0;
+				this->hasRandomSensorNeurons_ = false;
 			}
 
 			// copy assignment
@@ -88,8 +96,12 @@ namespace spike
 					{
 						//std::cerr << "SpikeStreamDataSet::add_private(): all Neurons are random." << std::endl;
 
+						if (!spikeCase->areEventsCompiled())
+						{
+							std::cerr << "spike::v3::SpikeStreamDataSet:add: WARNING: the spike times of the random case are not compiled into events; see SpikeCase::compileEvents." << std::endl;
+						}
 						this->useRandomCase_ = (spikeCase->getDuration() > 0);
-						this->currentCase_ = spikeCase;
+						this->currentCaseIndex_ = RANDOM_CASE;
 						this->randomCaseData_ = spikeCase;
 					}
 					else
@@ -103,9 +115,8 @@ namespace spike
 						else
 						{
 							//std::cout << "SpikeStreamDataSet::add_private(): adding with regular data caseId " << caseId << std::endl;
-							this->currentCase_ = spikeCase;
-							this->caseIdsVector_.push_back(caseId);
-							this->data_.insert(std::make_pair(caseId, spikeCase));
+							this->cases_.add(*spikeCase);
+							this->currentCaseIndex_ = this->cases_.getIndex(caseId);
 						}
 					}
 				}
@@ -117,14 +128,43 @@ namespace spike
 
 			bool hasCaseId(const CaseId caseId) const
 			{
-				return std::find(this->caseIdsVector_.cbegin(), this->caseIdsVector_.cend(), caseId) != this->caseIdsVector_.cend();
+				return this->cases_.hasCaseId(caseId);
+			}
+
+			// add a copy of the case with the provided id of the provided store, e.g. the store of another stream
+			void add(const SpikeCaseStore<Options>& cases, const CaseId caseId)
+			{
+				if (this->hasCaseId(caseId))
+				{
+					std::cerr << "spike::v3::SpikeStreamDataSet:add: WARNING: provided caseId " << caseId << " is already present." << std::endl;
+				}
+				else
+				{
+					this->cases_.add(cases, caseId);
+					this->currentCaseIndex_ = this->cases_.getIndex(caseId);
+				}
+			}
+
+			const SpikeCaseStore<Options>& getCaseStore() const
+			{
+				return this->cases_;
+			}
+
+			// take the regular cases from the provided online source instead of the stored cases: every regular case is the next
+			// case of the source, the store only holds the current case
+			void setCaseSource(const std::shared_ptr<SpikeCaseSource>& caseSource)
+			{
+				this->cases_.clearCases();
+				this->currentCaseIndex_ = RANDOM_CASE;
+				this->caseSource_ = caseSource;
+				this->caseSource_->start();
 			}
 
 			const std::shared_ptr<const SpikeCase<Options>> getSpikeCase(const CaseId caseId) const
 			{
 				if (this->hasCaseId(caseId))
 				{
-					auto spikeCase = this->data_.at(caseId);
+					auto spikeCase = this->cases_.toSpikeCase(this->cases_.getIndex(caseId), this->getAllNeuronIds());
 					#ifdef _DEBUG
 					if (spikeCase->getCaseId() != caseId)
 					{
@@ -148,12 +188,12 @@ namespace spike
 
 			const std::vector<CaseId> getCaseIds() const
 			{
-				return this->caseIdsVector_;
+				return this->cases_.getCaseIds();
 			}
 
 			size_t getNumberOfCases() const
 			{
-				return this->caseIdsVector_.size();
+				return this->cases_.getNumberOfCases();
 			}
 
 			void start()
@@ -168,30 +208,52 @@ namespace spike
 				//DEBUG_BREAK();
 			}
 
-			// return true if a next spike exists before future time, and advance the time to future time
-			std::tuple<bool, KernelTime> getNextSpikeTimeAndAdvance(const NeuronId neuronId, const KernelTime futureTime)
+			// call fire(neuronId, spikeTime) for every sensor spike before futureTime: first the events of the current case, in the
+			// order of SpikeCase::compileEvents, then the due random spikes of the sensor neurons that fire randomly in this case
+			template <typename F>
+			void forEachSensorSpike(const KernelTime futureTime, const F& fire)
 			{
-				const KernelTime spikeTime = this->nextSpikeTime_[neuronId];
-				const KernelTime randomSpikeTime = this->nextRandomSpikeTime_[neuronId];
+				const SensorEvent * const events = this->getCurrentEvents();
+				while (this->nextEventIndex_ < this->nEvents_)
+				{
+					const SensorEvent& event = events[this->nextEventIndex_];
+					const KernelTime spikeTime = this->currentCaseStartTime_ + event.offset;
+					if (spikeTime >= futureTime) break;
 
-				if (spikeTime < randomSpikeTime)
+					this->nextEventIndex_++;
+					fire(event.neuronId, spikeTime);
+				}
+				if (this->hasRandomSensorNeurons_)
 				{
-					const bool exists = (spikeTime < futureTime);// && (spikeTime >= this->currentTime_);
-					if (exists)
+					for (const NeuronId neuronId : Topology::iterator_SensorNeurons())
 					{
-						this->updateNextSpikeTime(neuronId);
+						const KernelTime randomSpikeTime = this->nextRandomSpikeTime_[neuronId];
+						if (randomSpikeTime < futureTime)
+						{
+							this->updateNextRandomSpikeTime(neuronId);
+							fire(neuronId, randomSpikeTime);
+						}
 					}
-					return std::make_tuple(exists, spikeTime);
 				}
-				else
+			}
+
+			// return the earliest time at which the stream needs the network: the next spike of a sensor neuron, or the end of the
+			// current case (advancing the time beyond it starts a new case)
+			KernelTime getNextEventTime() const
+			{
+				KernelTime result = this->currentCaseStartTime_ + this->durationCurrentCase_;
+				if (this->nextEventIndex_ < this->nEvents_)
 				{
-					const bool exists = (randomSpikeTime < futureTime);// && (spikeTime >= this->currentTime_);
-					if (exists)
+					result = std::min(result, this->currentCaseStartTime_ + this->getCurrentEvents()[this->nextEventIndex_].offset);
+				}
+				if (this->hasRandomSensorNeurons_)
+				{
+					for (const NeuronId neuronId : Topology::iterator_SensorNeurons())
 					{
-						this->updateNextRandomSpikeTime(neuronId);
+						result = std::min(result, this->nextRandomSpikeTime_[neuronId]);
 					}
-					return std::make_tuple(exists, randomSpikeTime);
 				}
+				return result;
 			}
 
 			void advanceCurrentTime(const KernelTime timeDelta)
@@ -213,8 +275,12 @@ namespace spike
 
 				//1] reset current state;
 				this->clearCaseUsage();
-				this->caseIdsVector_.clear();
-				this->data_.clear();
+				this->cases_.clear();
+				this->profileOfLabel_.clear();
+				this->caseSource_.reset();
+				this->currentCaseIndex_ = RANDOM_CASE;
+
+				const auto t1 = std::chrono::steady_clock::now();
 
 				//2]
 				const std::vector<NeuronId> neuronsInCases = spikeDataSet.getNeuronIds();
@@ -222,58 +288,90 @@ namespace spike
 				const size_t nSensorNeurons = Topology::Ns;
 
 				const std::vector<CaseId> caseIds = spikeDataSet.getCaseIds();
-
-
-				std::vector<NeuronId> allNeuronIds;
-				for (const NeuronId& neuronId : Topology::iterator_AllNeurons())
-				{
-					allNeuronIds.push_back(neuronId);
-				}
+				this->cases_.reserve(caseIds.size(), 0);
 
 				const TimeInMs caseTailSilenceInMs = static_cast<TimeInMs>(this->spikeRuntimeOptions_.getCaseTailSilenceInMs());
 				std::cout << "spike::v3::SpikeStreamDataSet:addSpikeDataSet: loading " << caseIds.size() << " cases with " << nNeuronsInCases << " neurons (with " << nSensorNeurons << " nSensorNeurons; tailSilence " << caseTailSilenceInMs << " ms)" << std::endl;
 
 				for (const CaseId& caseId : caseIds)
 				{
-
 					const TimeInMs caseDurationInMs = spikeDataSet.getCaseDuration(caseId);
 					if (caseDurationInMs > 1000)
 					{
 						std::cerr << "spike::v3::SpikeStreamDataSet:addSpikeDataSet: case duration of " << caseDurationInMs << " is too long for SpikeStreamDataSet, maximal length is 1000 ms." << std::endl;
 						//DEBUG_BREAK();
 					}
+					if (this->hasCaseId(caseId))
+					{
+						std::cerr << "spike::v3::SpikeStreamDataSet:addSpikeDataSet: WARNING: caseId " << caseId << " is already present." << std::endl;
+						continue;
+					}
 
 					// get the case label of the to be created new spike case
 					const CaseLabel caseLabel = spikeDataSet.getClassificationLabel(caseId);
 
-					// create the spike case
-					const auto spikeCase = std::make_shared<SpikeCase<Options>>(SpikeCase<Options>(caseId, caseLabel, allNeuronIds, caseDurationInMs, caseTailSilenceInMs));
-
-					// set the randomHz of all the neurons equal to the random spike Hz
-					spikeCase->setAllNeuronsRandomSpikeHz(this->spikeRuntimeOptions_.getRandomSpikeHz());
-					for (const NeuronId& sensorNeuronId : Topology::iterator_SensorNeurons())
+					// add the spikes of the caseData to the arena
+					for (const NeuronId& neuronId : spikeDataSet.getNeuronIds())
 					{
-						spikeCase->setRandomSpikeHz(sensorNeuronId, 0);
+						this->cases_.addSpikeTimes(Topology::translateToSensorNeuronId(neuronId), spikeDataSet.getSpikeTimes(caseId, neuronId));
 					}
+					this->cases_.endCase(caseId, caseLabel, caseDurationInMs, caseTailSilenceInMs, this->getProfile(caseLabel));
+				}
+				if (this->cases_.getNumberOfCases() > 0)
+				{
+					this->currentCaseIndex_ = static_cast<unsigned int>(this->cases_.getNumberOfCases() - 1);
+				}
+
+				const auto t2 = std::chrono::steady_clock::now();
+				const double MB = 1024 * 1024;
+				std::cout << "spike::v3::SpikeStreamDataSet:addSpikeDataSet: loaded " << this->cases_.getNumberOfCases() << " cases with " << this->cases_.getNumberOfEvents() << " spikes in " << std::chrono::duration<double, std::milli>(t2 - t1).count() << " ms; case store uses " << (this->cases_.getMemoryUsage() / MB) << " MB" << std::endl;
+			}
 
-					// set the randomHz of the motor neuron
-					for (const NeuronId& motorNeuronId : Topology::iterator_MotorNeurons())
+			// add the cases of a binary spike data set without copying its spikes: the case store refers to the events in the
+			// mapped file and keeps the data set alive
+			void addSpikeDataSet(
+				const std::shared_ptr<const SpikeDataSetBinary<Topology>>& spikeDataSet)
+			{
+				//1] reset current state;
+				this->clearCaseUsage();
+				this->cases_.clear();
+				this->profileOfLabel_.clear();
+				this->caseSource_.reset();
+				this->currentCaseIndex_ = RANDOM_CASE;
+
+				const auto t1 = std::chrono::steady_clock::now();
+
+				//2]
+				const TimeInMs caseTailSilenceInMs = static_cast<TimeInMs>(this->spikeRuntimeOptions_.getCaseTailSilenceInMs());
+				std::cout << "spike::v3::SpikeStreamDataSet:addSpikeDataSet: loading " << spikeDataSet->getNumberOfCases() << " cases from a binary data set (tailSilence " << caseTailSilenceInMs << " ms)" << std::endl;
+
+				this->cases_.setExternalEvents(spikeDataSet->getEvents(), spikeDataSet->getNumberOfEvents(), spikeDataSet);
+				this->cases_.reserve(spikeDataSet->getNumberOfCases(), 0);
+
+				for (size_t i = 0; i < spikeDataSet->getNumberOfCases(); ++i)
+				{
+					const typename SpikeDataSetBinary<Topology>::CaseEntry& entry = spikeDataSet->getCase(i);
+					const CaseId caseId = CaseId(entry.caseId);
+					if (entry.durationInMs > 1000)
 					{
-						spikeCase->setRandomSpikeHz(motorNeuronId, 0);
+						std::cerr << "spike::v3::SpikeStreamDataSet:addSpikeDataSet: case duration of " << entry.durationInMs << " is too long for SpikeStreamDataSet, maximal length is 1000 ms." << std::endl;
 					}
-					const NeuronId correctMotorNeuronId = Topology::translateToMotorNeuronId(caseLabel);
-					spikeCase->setRandomSpikeHz(correctMotorNeuronId, static_cast<float>(this->spikeRuntimeOptions_.getCorrectNeuronSpikeHz()));
-
-					// set the spikes of the caseData
-					for (const NeuronId& neuronId : spikeDataSet.getNeuronIds())
+					if (this->hasCaseId(caseId))
 					{
-						const NeuronId sensorNeuronId = Topology::translateToSensorNeuronId(neuronId);
-						spikeCase->setSpikeTimes(sensorNeuronId, spikeDataSet.getSpikeTimes(caseId, neuronId));
+						std::cerr << "spike::v3::SpikeStreamDataSet:addSpikeDataSet: WARNING: caseId " << caseId << " is already present." << std::endl;
+						continue;
 					}
-
-					// add (move) the newly created case to this spike stream
-					this->add(std::move(spikeCase));
+					const CaseLabel caseLabel = CaseLabel(entry.caseLabel);
+					this->cases_.addExternalCase(caseId, caseLabel, entry.durationInMs, caseTailSilenceInMs, this->getProfile(caseLabel), entry.eventsBegin, entry.eventsEnd);
 				}
+				if (this->cases_.getNumberOfCases() > 0)
+				{
+					this->currentCaseIndex_ = static_cast<unsigned int>(this->cases_.getNumberOfCases() - 1);
+				}
+
+				const auto t2 = std::chrono::steady_clock::now();
+				const double MB = 1024 * 1024;
+				std::cout << "spike::v3::SpikeStreamDataSet:addSpikeDataSet: loaded " << this->cases_.getNumberOfCases() << " cases with " << this->cases_.getNumberOfEvents() << " spikes in " << std::chrono::duration<double, std::milli>(t2 - t1).count() << " ms; case store uses " << (this->cases_.getMemoryUsage() / MB) << " MB; mapped " << (spikeDataSet->getFileSize() / MB) << " MB" << std::endl;
 			}
 
 			const std::vector<CaseOccurance<TimeInMs>>& getCaseUsage() const
@@ -291,11 +389,29 @@ namespace spike
 				return this->currentCaseLabel_;
 			}
 
+			// return the time at which the current case started; changes when a new case starts
+			KernelTime getCurrentCaseStartTime() const
+			{
+				return this->currentCaseStartTime_;
+			}
+
+			// end the current regular case before its duration plus tail silence: record the decision and its latency in the case
+			// occurance and start the next case
+			void endCurrentCase(const CaseLabel decisionLabel)
+			{
+				::tools::assert::assert_msg(this->currentCaseLabel_ != NO_CASE_LABEL, "spike::v3::SpikeStreamDataSet::endCurrentCase: the current case is not a regular case");
+				CaseOccurance<TimeInMs>& caseOccurance = this->caseOccurances_.back();
+				caseOccurance.decisionLabel_ = decisionLabel.val;
+				caseOccurance.decisionLatency_ = Options::toTimeInMs(this->currentTimeInCase_);
+				caseOccurance.endTime_ = Options::toTimeInMs(this->currentTime_);
+				this->startNewCase();
+			}
+
 			std::string toString() const
 			{
 				std::ostringstream oss;
 
-				oss << "spike::v3::SpikeStreamDataSet: currentTimeInCase=" << this->currentTimeInCase_ << "ms; nCases=" << this->getNumberOfCases() << "; current CaseId=" << this->currentCase_->getCaseId() << "; current label=" << this->getCurrentLabel() << std::endl;
+				oss << "spike::v3::SpikeStreamDataSet: currentTimeInCase=" << this->currentTimeInCase_ << "ms; nCases=" << this->getNumberOfCases() << "; current CaseId=" << ((this->currentCaseIndex_ == RANDOM_CASE) ? this->randomCaseData_->getCaseId() : this->cases_.getCase(this->currentCaseIndex_).caseId) << "; current label=" << this->getCurrentLabel() << std::endl;
 
 				if (this->useRandomCase_)
 				{
@@ -306,10 +422,11 @@ namespace spike
 					oss << "no random case;" << std::endl;
 				}
 
-				for (const CaseId& caseId : this->caseIdsVector_)
+				for (size_t index = 0; index < this->cases_.getNumberOfCases(); ++index)
 				{
-					oss << "case Id " << caseId.val << ":" << std::endl;
-					oss << this->data_.at(caseId)->toString() << std::endl;
+					const typename SpikeCaseStore<Options>::CaseRecord& record = this->cases_.getCase(index);
+					oss << "case Id " << record.caseId.val << ":" << std::endl;
+					oss << "spikeCase " << record.caseId << "; label=" << record.caseLabel << "; nSpikes=" << (record.eventsEnd - record.eventsBegin) << "; caseLength=" << record.duration << "; tailSilence=" << record.tailSilence << std::endl;
 				}
 				return oss.str();
 			}
@@ -327,22 +444,27 @@ namespace spike
 
 			bool useRandomCase_;
 			std::shared_ptr<const SpikeCase<Options>> randomCaseData_;
-			std::shared_ptr<const SpikeCase<Options>> currentCase_;
+
+			// position of the current case in cases_, RANDOM_CASE when the current case is randomCaseData_
+			static const unsigned int RANDOM_CASE = SpikeCaseStore<Options>::NO_INDEX;
+			unsigned int currentCaseIndex_;
 
 			std::vector<CaseOccurance<TimeInMs>> caseOccurances_;
 
-			// next spike time is the current case's next spike time
-			std::array<KernelTime, nNeurons> nextSpikeTime_;
+			// cursor in the events of the current case; nEvents_ is zero until the first case starts
+			size_t nextEventIndex_;
+			size_t nEvents_;
+			bool hasRandomSensorNeurons_; // whether sensor neurons of the current case fire randomly
 
-			// next index of the next spike in the spikeDataSet
-			std::array<unsigned int, nNeurons> nextSpikeIndex_;
 
+			SpikeCaseStore<Options> cases_; // the regular cases
+			std::map<CaseLabelType, unsigned int> profileOfLabel_; // the random fire rates only depend on the case label
 
-			std::vector<CaseId> caseIdsVector_;
-			std::map<CaseId, std::shared_ptr<const SpikeCase<Options>>> data_;
+			std::shared_ptr<SpikeCaseSource> caseSource_; // if set, the source of the regular cases
+			EncodedCase sourceCase_;
 
 			unsigned int randInt_;
-			// randomSpikeHz is a cache of currentCase_->randomSpikeHz
+			// randomSpikeHz is a cache of the random fire rates of the current case
 			std::array<float, nNeurons> randomSpikeHz_;
 			std::array<unsigned int, nNeurons> randomSpikeHzInteger_;
 			std::array<KernelTime, nNeurons> nextRandomSpikeTime_;
@@ -352,7 +474,7 @@ namespace spike
 			{
 				//std::cout << "spike::v3::SpikeStreamDataSet::startNewCase: starting a new case" << std::endl;
 
-				if (!this->currentCase_)
+				if (!this->randomCaseData_ && (this->cases_.getNumberOfCases() == 0) && !this->caseSource_)
 				{
 					std::cout << "spike::v3::SpikeStreamDataSet::startNewCase: trying to start a new case, but there is no current case" << std::endl;
 					//DEBUG_BREAK();
@@ -360,18 +482,19 @@ namespace spike
 
 				this->currentTimeInCase_ = 0; // reset the current position in the current case
 				this->currentCaseStartTime_ = this->currentTime_;
+				::tools::assert::assert_msg((this->currentCaseStartTime_ % std::max<KernelTime>(1, Options::toKernelTime(static_cast<TimeInMs>(Options::minDelay)))) == 0, "spike::v3::SpikeStreamDataSet::startNewCase: the events of a case are sorted by window, hence a case has to start at the start of a window");
 
-				if (this->currentCase_->areAllNeuronsRandom())
+				if (this->currentCaseIndex_ == RANDOM_CASE)
 				{  // the current (previous) case was complete random
 //std::cout << "spike::v3::SpikeStreamDataSet::startNewCase(): A: current case is random" << std::endl;
-					if (this->caseIdsVector_.size() > 0)
+					if ((this->cases_.getNumberOfCases() > 0) || this->caseSource_)
 					{
 						this->startNewRegularCase();
 					}
 					else
 					{
 						//std::cout << "spike::v3::SpikeCases::startNewCase(): A: next cases is random case" << std::endl;
-						this->currentCase_ = this->randomCaseData_;
+						this->currentCaseIndex_ = RANDOM_CASE;
 						this->currentCaseLabel_ = NO_CASE_LABEL;
 					}
 				}
@@ -381,7 +504,7 @@ namespace spike
 					if (this->useRandomCase_)
 					{
 						//std::cout << "spike::v3::SpikeStreamDataSet::startNewCase(): B: next cases is random case" << std::endl;
-						this->currentCase_ = this->randomCaseData_;
+						this->currentCaseIndex_ = RANDOM_CASE;
 						this->currentCaseLabel_ = NO_CASE_LABEL;
 					}
 					else
@@ -389,16 +512,28 @@ namespace spike
 						this->startNewRegularCase();
 					}
 				}
+				if (this->currentCaseIndex_ == RANDOM_CASE)
+				{	// the duration of a regular case is set by startNewRegularCase
+					this->durationCurrentCase_ = Options::toKernelTime(this->randomCaseData_->getDurationPlusSilence());
+				}
+				this->nextEventIndex_ = 0;
+				this->nEvents_ = (this->currentCaseIndex_ == RANDOM_CASE)
+					? this->randomCaseData_->getEvents().size()
+					: (this->cases_.getCase(this->currentCaseIndex_).eventsEnd - this->cases_.getCase(this->currentCaseIndex_).eventsBegin);
 				this->updateAllNextRandomSpikes();
 			}
 
 			void startNewRegularCase()
 			{
 				const size_t nCases = this->getNumberOfCases();
-				::tools::assert::assert_msg(nCases > 0, "number of cases is too small");
+				::tools::assert::assert_msg((nCases > 0) || this->caseSource_, "number of cases is too small");
 
 				size_t randomIndex;
-				if (false)
+				if (this->caseSource_)
+				{
+					randomIndex = this->loadNextSourceCase();
+				}
+				else if (false)
 				{
 					randomIndex = (nCases <= 1) ? 0 : static_cast<size_t>(::tools::random::rand_int32(0U, static_cast<unsigned int>(nCases)));
 				}
@@ -413,35 +548,35 @@ namespace spike
 				}
 				//std::cout << "spike::v3::SpikeStreamDataSet:startNewRegularCase:: randomIndex=" << randomIndex << std::endl;
 
-				const CaseId randomCaseId = this->caseIdsVector_[randomIndex];
-				this->currentCase_ = this->data_[randomCaseId];
+				this->currentCaseIndex_ = static_cast<unsigned int>(randomIndex);
+				const typename SpikeCaseStore<Options>::CaseRecord& currentCase = this->cases_.getCase(randomIndex);
+				const CaseId randomCaseId = currentCase.caseId;
 
-				this->nextSpikeIndex_.fill(0);
-				for (const NeuronId& neuronId : Topology::iterator_SensorNeurons())
-				{
-					this->updateNextSpikeTime(neuronId);
-				}
 				for (const NeuronId& neuronId : Topology::iterator_MotorNeurons())
 				{
 					this->updateNextRandomSpikeTime(neuronId);
 				}
 
-				this->currentCaseLabel_ = this->currentCase_->getCaseLabel();
-				this->durationCurrentCase_ = Options::toKernelTime(this->currentCase_->getDurationPlusSilence());
+				this->currentCaseLabel_ = currentCase.caseLabel;
+				this->durationCurrentCase_ = Options::toKernelTime(currentCase.getDurationPlusSilence());
 
 				const TimeInMs startTime = Options::toTimeInMs(this->currentCaseStartTime_);
-				const TimeInMs endTime = startTime + this->currentCase_->getDurationPlusSilence();
+				const TimeInMs endTime = startTime + currentCase.getDurationPlusSilence();
 				//std::cout << "spike::v3::SpikeStreamDataSet:startNewRegularCase:: caseId=" << randomCaseId << "; caseLabel=" << this->currentCaseLabel_ << "; startTime=" << startTime << "; endTime=" << endTime << std::endl;
 				this->caseOccurances_.push_back(CaseOccurance<TimeInMs>(randomCaseId, startTime, endTime, this->currentCaseLabel_));
 			}
 
 			void updateAllNextRandomSpikes()
 			{
-				//std::cout << "spike::v3::SpikeStreamDataSet:updateAllNextRandomSpikes: entering; currentCase=" << this->currentCase_->toString() << std::endl;
+				//std::cout << "spike::v3::SpikeStreamDataSet:updateAllNextRandomSpikes: entering; currentCaseIndex=" << this->currentCaseIndex_ << std::endl;
 
-				for (const NeuronId& neuronId : this->currentCase_->getNeuronIds())
+				const bool isRandomCase = (this->currentCaseIndex_ == RANDOM_CASE);
+				const std::vector<NeuronId>& neuronIds = (isRandomCase) ? this->randomCaseData_->getNeuronIds() : this->getAllNeuronIds();
+				for (const NeuronId& neuronId : neuronIds)
 				{
-					const float randHz = this->currentCase_->getRandomFireHz(neuronId);
+					const float randHz = (isRandomCase)
+						? this->randomCaseData_->getRandomFireHz(neuronId)
+						: this->cases_.getRandomFireHz(this->cases_.getCase(this->currentCaseIndex_).profile)[neuronId];
 					//std::cout << "spike::v3::SpikeStreamDataSet:updateAllNextRandomSpikes: neuronId=" << neuronId << " randHz=" << randHz << std::endl;
 
 					if (this->randomSpikeHz_[neuronId] != randHz)
@@ -453,6 +588,76 @@ namespace spike
 						this->updateNextRandomSpikeTime(neuronId);
 					}
 				}
+				this->hasRandomSensorNeurons_ = false;
+				for (const NeuronId& neuronId : Topology::iterator_SensorNeurons())
+				{
+					if (this->randomSpikeHzInteger_[neuronId] > 0)
+					{
+						this->hasRandomSensorNeurons_ = true;
+					}
+				}
+			}
+
+			// return the profile with the random fire rates of a regular case with the provided label: the random spike Hz for all
+			// neurons, except the sensor neurons and the incorrect motor neurons
+			unsigned int getProfile(const CaseLabel caseLabel)
+			{
+				const auto it = this->profileOfLabel_.find(caseLabel.val);
+				if (it != this->profileOfLabel_.end())
+				{
+					return it->second;
+				}
+				std::vector<float> randomFireHz(nNeurons, static_cast<float>(this->spikeRuntimeOptions_.getRandomSpikeHz()));
+				for (const NeuronId& sensorNeuronId : Topology::iterator_SensorNeurons())
+				{
+					randomFireHz[sensorNeuronId] = 0;
+				}
+				for (const NeuronId& motorNeuronId : Topology::iterator_MotorNeurons())
+				{
+					randomFireHz[motorNeuronId] = 0;
+				}
+				randomFireHz[Topology::translateToMotorNeuronId(caseLabel)] = static_cast<float>(this->spikeRuntimeOptions_.getCorrectNeuronSpikeHz());
+				const unsigned int profile = this->cases_.addProfile(randomFireHz);
+				this->profileOfLabel_[caseLabel.val] = profile;
+				return profile;
+			}
+
+			// replace the case in the store by the next case of the source; return its position
+			size_t loadNextSourceCase()
+			{
+				if (!this->caseSource_->next(this->sourceCase_))
+				{
+					std::cerr << "spike::v3::SpikeStreamDataSet:loadNextSourceCase: the case source has stopped" << std::endl;
+					throw std::runtime_error("the case source has stopped");
+				}
+				this->cases_.clearCases();
+				for (const SensorEvent& event : this->sourceCase_.events)
+				{
+					this->cases_.addEvent(SensorEvent(event.offset, Topology::translateToSensorNeuronId(event.neuronId)));
+				}
+				const TimeInMs caseTailSilenceInMs = static_cast<TimeInMs>(this->spikeRuntimeOptions_.getCaseTailSilenceInMs());
+				this->cases_.endCase(this->sourceCase_.caseId, this->sourceCase_.caseLabel, this->caseSource_->getCaseDurationInMs(), caseTailSilenceInMs, this->getProfile(this->sourceCase_.caseLabel));
+				return 0;
+			}
+
+			// return the first event of the current case
+			const SensorEvent * getCurrentEvents() const
+			{
+				return (this->currentCaseIndex_ == RANDOM_CASE) ? this->randomCaseData_->getEvents().data() : this->cases_.getEvents(this->currentCaseIndex_);
+			}
+
+			static const std::vector<NeuronId>& getAllNeuronIds()
+			{
+				static const std::vector<NeuronId> allNeuronIds = []()
+				{
+					std::vector<NeuronId> neuronIds;
+					for (const NeuronId& neuronId : Topology::iterator_AllNeurons())
+					{
+						neuronIds.push_back(neuronId);
+					}
+					return neuronIds;
+				}();
+				return allNeuronIds;
 			}
 
 			void updateNextRandomSpikeTime(const NeuronId neuronId)
@@ -474,25 +679,6 @@ namespace spike
 					this->nextRandomSpikeTime_[neuronId] = LAST_KERNEL_TIME;
 				}
 			}
-
-			void updateNextSpikeTime(const NeuronId neuronId)
-			{
-				const std::vector<TimeInMs> spikeTimes = this->currentCase_->getSpikeTimes(neuronId);
-
-				unsigned int index = this->nextSpikeIndex_[neuronId];
-				if (index < spikeTimes.size())
-				{
-					this->nextSpikeTime_[neuronId] = this->currentTime_ + Options::toKernelTime(spikeTimes[index]);
-					index++;
-					this->nextSpikeIndex_[neuronId] = index;
-					//std::cout << "spike::v3::SpikeStreamDataSet::updateNextSpikeTime: neuron " << neuronId << ": setting next spike time to " << this->nextSpikeTime_[neuronId] << std::endl;
-				}
-				else
-				{
-					this->nextSpikeTime_[neuronId] = LAST_KERNEL_TIME;
-				}
-				//std::cout << "spike::v3::SpikeStreamDataSet::updateNextSpikeTime: neuron " << neuronId << ": setting next spike time to " << this->nextSpikeTime_[neuronId] << std::endl;
-			}
 		};
 	}
 }
\ No newline at end of file
@@ -26,6 +26,7 @@
 #include <vector>
 #include <memory>
 #include <limits>		// std::numeric_limits
+#include <algorithm>	// std::stable_sort, std::min, std::max
 
 #include "Types.hpp"
 #include "SpikeOptionsStatic.hpp"
@@ -48,12 +49,15 @@ namespace spike
 			Synapses()
 				: w_(std::vector<float>(nNeurons*nNeurons, std::numeric_limits<float>::quiet_NaN()))
 				, delay_(std::vector<KernelTime>(nNeurons*nNeurons, -1))
-				, wd_plus_(std::vector<unsigned int>(nNeurons*nNeurons, 0))
-				, wd_min_(std::vector<unsigned int>(nNeurons*nNeurons, 0))
-				, lastDeliverTime_(std::vector<KernelTime>(nNeurons*nNeurons, -1000 * Options::nSubMs))
+				, wd_plus_(std::vector<float>(nPlasticSynapses, 0))
+				, wd_min_(std::vector<float>(nPlasticSynapses, 0))
+				, lastDeliverTime_(std::vector<KernelTime>(nPlasticSynapses, -1000 * Options::nSubMs))
 
 				, outgoingNeurons_(nNeurons, std::vector<NeuronId>())
 				, incommingNeurons_(nNeurons, std::vector<NeuronId>())
+				, outgoingSynapses_(nNeurons, std::vector<SynapseId>())
+				, incommingSynapses_(nNeurons, std::vector<SynapseId>())
+				, delayGroups_(nNeurons, std::vector<DelayGroup>())
 			{
 				//	for (size_t i = 0; i < this->incommingSpikes_.size(); ++i) {
 				//		this->incommingSpikes_[i] = std::make_shared<std::vector<std::tuple<NeuronId, NeuronId>>>(40000);
@@ -68,21 +72,43 @@ namespace spike
 				{
 
 					std::vector<NeuronId>& outgoingNeurons = this->outgoingNeurons_[neuronId];
+					std::vector<SynapseId>& outgoingSynapses = this->outgoingSynapses_[neuronId];
+					std::vector<DelayGroup>& delayGroups = this->delayGroups_[neuronId];
 					outgoingNeurons.clear();
-					for (const Pathway& p : topology->getOutgoingPathways(neuronId))
+					outgoingSynapses.clear();
+					delayGroups.clear();
+
+					// the outgoing synapses are sorted by delay, such that the synapses with the same delay are consecutive
+					std::vector<Pathway> pathways = topology->getOutgoingPathways(neuronId);
+					std::stable_sort(pathways.begin(), pathways.end(), [](const Pathway& p1, const Pathway& p2) { return p1.delay < p2.delay; });
+					for (const Pathway& p : pathways)
 					{
 						::tools::assert::assert_msg(p.origin == neuronId, "incorrect origin");
+						const KernelTime delay = Options::toKernelTime(static_cast<TimeInMs>(p.delay));
+						const unsigned int pos = static_cast<unsigned int>(outgoingSynapses.size());
+						if (delayGroups.empty() || (delayGroups.back().delay != delay))
+						{
+							delayGroups.push_back(DelayGroup(delay, pos, pos + 1));
+						}
+						else
+						{
+							delayGroups.back().end = pos + 1;
+						}
 						outgoingNeurons.push_back(p.destination);
+						outgoingSynapses.push_back(this->getSynapseId(neuronId, p.destination));
 						this->setWeight(neuronId, p.destination, p.efficacy);
-						this->setDelay(neuronId, p.destination, Options::toKernelTime(static_cast<TimeInMs>(p.delay)));
+						this->setDelay(neuronId, p.destination, delay);
 					}
 
 					std::vector<NeuronId>& incommingNeurons = this->incommingNeurons_[neuronId];
+					std::vector<SynapseId>& incommingSynapses = this->incommingSynapses_[neuronId];
 					incommingNeurons.clear();
+					incommingSynapses.clear();
 					for (const Pathway& p : topology->getIncommingPathways(neuronId))
 					{
 						::tools::assert::assert_msg(p.destination == neuronId, "incorrect destination");
 						incommingNeurons.push_back(p.origin);
+						incommingSynapses.push_back(this->getSynapseId(p.origin, neuronId));
 					}
 				}
 			}
@@ -167,15 +193,150 @@ namespace spike
 				this->delay_[this->index(origin, destination)] = delay;
 			}
 
+			//=================================================================
+			// access by synapse id; the id of the synapse from origin to destination is origin*nNeurons + destination
+
+			SynapseId getSynapseId(const NeuronId origin, const NeuronId destination) const
+			{
+				return static_cast<SynapseId>(this->index(origin, destination));
+			}
+
+			NeuronId getOrigin(const SynapseId synapseId) const
+			{
+				return static_cast<NeuronId>(synapseId / nNeurons);
+			}
+
+			NeuronId getDestination(const SynapseId synapseId) const
+			{
+				return static_cast<NeuronId>(synapseId % nNeurons);
+			}
+
+			const std::vector<SynapseId>& getOutgoingSynapses(const NeuronId origin) const
+			{
+				return this->outgoingSynapses_[origin];
+			}
+
+			// return the outgoing synapses of the provided origin grouped by delay, in increasing delay
+			const std::vector<DelayGroup>& getOutgoingDelayGroups(const NeuronId origin) const
+			{
+				return this->delayGroups_[origin];
+			}
+
+			// return the outgoing synapses of the provided origin in the provided delay group
+			SynapseIdSpan getOutgoingSynapses(const NeuronId origin, const DelayGroup& delayGroup) const
+			{
+				const SynapseId * const data = this->outgoingSynapses_[origin].data();
+				return SynapseIdSpan(data + delayGroup.begin, data + delayGroup.end);
+			}
+
+			const std::vector<SynapseId>& getIncommingSynapses(const NeuronId destination) const
+			{
+				return this->incommingSynapses_[destination];
+			}
+
+			float getWeight(const SynapseId synapseId) const
+			{
+				return this->w_[synapseId];
+			}
+
+			void incWeight(const SynapseId synapseId, const float value)
+			{
+				this->w_[synapseId] = clampWeight(this->w_[synapseId] + value);
+			}
+
+			void decWeight(const SynapseId synapseId, const float value)
+			{
+				this->w_[synapseId] = clampWeight(this->w_[synapseId] - value);
+			}
+
+			// the weight changes with Options::deferWeightUpdates: the change is accumulated and applied by flushWeightDeltas
+			void incWeightDeferred(const SynapseId synapseId, const float value)
+			{
+				this->markChanged(synapseId, value);
+				this->wd_plus_[synapseId] += value;
+			}
+
+			void decWeightDeferred(const SynapseId synapseId, const float value)
+			{
+				this->markChanged(synapseId, value);
+				this->wd_min_[synapseId] += value;
+			}
+
+			// apply the accumulated weight changes, clamped once, and reset them. Only the synapses changed since the last flush
+			// are visited; the other synapses are left untouched (inhibitory weights are outside the clamp range, absent synapses
+			// are NaN).
+			void flushWeightDeltas()
+			{
+				for (const SynapseId synapseId : this->changedSynapses_)
+				{
+					const float newWeight = this->w_[synapseId] + this->wd_plus_[synapseId] - this->wd_min_[synapseId];
+					this->w_[synapseId] = std::min(static_cast<float>(Options::maxExcWeight), std::max(static_cast<float>(Options::minExcWeight), newWeight));
+					this->wd_plus_[synapseId] = 0;
+					this->wd_min_[synapseId] = 0;
+				}
+				this->changedSynapses_.clear();
+			}
+
+			KernelTime getDelay(const SynapseId synapseId) const
+			{
+				return this->delay_[synapseId];
+			}
+
+			KernelTime getLastDeliverTime(const SynapseId synapseId) const
+			{
+				return this->lastDeliverTime_[synapseId];
+			}
+
+			void setLastDeliverTime(const SynapseId synapseId, const KernelTime t)
+			{
+				this->lastDeliverTime_[synapseId] = t;
+			}
+
+			// return the number of bytes allocated
+			size_t getMemoryUsage() const
+			{
+				size_t result = (this->w_.capacity() * sizeof(float))
+					+ (this->wd_plus_.capacity() * sizeof(float))
+					+ (this->wd_min_.capacity() * sizeof(float))
+					+ (this->changedSynapses_.capacity() * sizeof(SynapseId))
+					+ (this->lastDeliverTime_.capacity() * sizeof(KernelTime))
+					+ (this->delay_.capacity() * sizeof(KernelTime));
+				for (const NeuronId neuronId : Topology::iterator_AllNeurons())
+				{
+					result += this->outgoingNeurons_[neuronId].capacity() * sizeof(NeuronId);
+					result += this->incommingNeurons_[neuronId].capacity() * sizeof(NeuronId);
+					result += this->outgoingSynapses_[neuronId].capacity() * sizeof(SynapseId);
+					result += this->incommingSynapses_[neuronId].capacity() * sizeof(SynapseId);
+					result += this->delayGroups_[neuronId].capacity() * sizeof(DelayGroup);
+				}
+				return result;
+			}
+
 		private:
 
+			// with Options::inferenceOnly the weights are read-only and the STDP state is not allocated
+			static const size_t nPlasticSynapses = (Options::inferenceOnly) ? 0 : nNeurons*nNeurons;
+
 			std::vector<float> w_;
-			std::vector<unsigned int> wd_plus_;
-			std::vector<unsigned int> wd_min_;
+			std::vector<float> wd_plus_; // deferred weight increases, see flushWeightDeltas
+			std::vector<float> wd_min_; // deferred weight decreases, see flushWeightDeltas
+			std::vector<SynapseId> changedSynapses_; // the synapses with a deferred change, see markChanged
 			std::vector<KernelTime> lastDeliverTime_;
 
 			std::vector<std::vector<NeuronId>> outgoingNeurons_;
 			std::vector<std::vector<NeuronId>> incommingNeurons_;
+			std::vector<std::vector<SynapseId>> outgoingSynapses_;
+			std::vector<std::vector<SynapseId>> incommingSynapses_;
+			std::vector<std::vector<DelayGroup>> delayGroups_;
+
+			// remember the synapse at its first non-zero change since the last flush
+			void markChanged(const SynapseId synapseId, const float value)
+			{
+				if ((value != 0) && (this->wd_plus_[synapseId] == 0) && (this->wd_min_[synapseId] == 0))
+				{
+					this->changedSynapses_.push_back(synapseId);
+				}
+			}
 
 			std::vector<KernelTime> delay_;
 
@@ -184,6 +345,19 @@ namespace spike
 				return (origin * Options::nNeurons) + destination;
 			}
 
+			static float clampWeight(const float weight)
+			{
+				if (weight > Options::maxExcWeight)
+				{
+					return Options::maxExcWeight;
+				}
+				else if (weight < Options::minExcWeight)
+				{
+					return Options::minExcWeight;
+				}
+				return weight;
+			}
+
 			void check(const NeuronId origin, const NeuronId destination) const
 			{
 				::tools::assert::assert_msg(!std::isnan(this->w_[this->index(origin, destination)]), "position not initialized: origin=", origin, "; destination=", destination);
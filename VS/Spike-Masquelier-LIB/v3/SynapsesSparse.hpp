@@ -0,0 +1,355 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>	// std::stable_sort, std::sort, std::lower_bound, std::min, std::max
+#include <type_traits>	// std::conditional
+
+#include "Types.hpp"
+#include "SpikeOptionsStatic.hpp"
+
+namespace spike
+{
+	namespace v3
+	{
+		// Compressed sparse row alternative for Synapses: memory is O(number of synapses) instead of O(nNeurons^2).
+		// The synapses are numbered by origin: the outgoing synapses of a neuron have consecutive ids, sorted by delay and
+		// otherwise in the order of the pathways in the topology. The incomming synapses of a neuron are an index array into
+		// the same records.
+		template <typename Topology_i>
+		class SynapsesSparse
+		{
+		public:
+
+			using Topology = Topology_i;
+			using Options = typename Topology_i::Options;
+
+			static const size_t nNeurons = Options::nNeurons;
+
+			// constructor
+			SynapsesSparse()
+				: outgoingBegin_(std::vector<SynapseId>(nNeurons + 1, 0))
+				, incommingBegin_(std::vector<SynapseId>(nNeurons + 1, 0))
+				, delayGroups_(std::vector<std::vector<DelayGroup>>(nNeurons))
+			{
+			}
+
+			void init(const std::shared_ptr<Topology>& topology)
+			{
+				this->synapses_.clear();
+				this->wd_plus_.clear();
+				this->wd_min_.clear();
+				this->changedSynapses_.clear();
+				this->origin_.clear();
+				this->destination_.clear();
+				this->outgoingByDestination_.clear();
+				this->incommingSynapses_.clear();
+
+				// 1] the outgoing synapses: one record per pathway, grouped by origin and within an origin by delay
+				for (const NeuronId neuronId : Topology::iterator_AllNeurons())
+				{
+					this->outgoingBegin_[neuronId] = static_cast<SynapseId>(this->synapses_.size());
+					std::vector<Pathway> pathways = topology->getOutgoingPathways(neuronId);
+					std::stable_sort(pathways.begin(), pathways.end(), [](const Pathway& p1, const Pathway& p2) { return p1.delay < p2.delay; });
+
+					std::vector<DelayGroup>& delayGroups = this->delayGroups_[neuronId];
+					delayGroups.clear();
+					for (const Pathway& p : pathways)
+					{
+						::tools::assert::assert_msg(p.origin == neuronId, "incorrect origin");
+						const KernelTime delay = Options::toKernelTime(static_cast<TimeInMs>(p.delay));
+						const unsigned int pos = static_cast<unsigned int>(this->synapses_.size() - this->outgoingBegin_[neuronId]);
+						if (delayGroups.empty() || (delayGroups.back().delay != delay))
+						{
+							delayGroups.push_back(DelayGroup(delay, pos, pos + 1));
+						}
+						else
+						{
+							delayGroups.back().end = pos + 1;
+						}
+						this->synapses_.push_back(Synapse(p.efficacy, delay));
+						this->origin_.push_back(p.origin);
+						this->destination_.push_back(p.destination);
+					}
+				}
+				this->outgoingBegin_[nNeurons] = static_cast<SynapseId>(this->synapses_.size());
+
+				// the outgoing synapses of every neuron sorted by destination, for getSynapseId
+				for (const NeuronId neuronId : Topology::iterator_AllNeurons())
+				{
+					for (SynapseId synapseId = this->outgoingBegin_[neuronId]; synapseId < this->outgoingBegin_[neuronId + 1]; ++synapseId)
+					{
+						this->outgoingByDestination_.push_back(synapseId);
+					}
+					std::sort(this->outgoingByDestination_.begin() + this->outgoingBegin_[neuronId], this->outgoingByDestination_.end(), [this](const SynapseId s1, const SynapseId s2) { return this->destination_[s1] < this->destination_[s2]; });
+				}
+
+				if (!Options::inferenceOnly)
+				{
+					this->wd_plus_.resize(this->synapses_.size(), 0);
+					this->wd_min_.resize(this->synapses_.size(), 0);
+				}
+
+				// 2] the incomming synapses: index into the outgoing synapses, grouped by destination
+				for (const NeuronId neuronId : Topology::iterator_AllNeurons())
+				{
+					this->incommingBegin_[neuronId] = static_cast<SynapseId>(this->incommingSynapses_.size());
+					for (const Pathway& p : topology->getIncommingPathways(neuronId))
+					{
+						::tools::assert::assert_msg(p.destination == neuronId, "incorrect destination");
+						const SynapseId synapseId = this->getSynapseId(p.origin, p.destination);
+						::tools::assert::assert_msg(synapseId != NO_SYNAPSE, "spike::v3::SynapsesSparse::init: no outgoing synapse for incomming pathway: origin=", p.origin, "; destination=", p.destination);
+						this->incommingSynapses_.push_back(synapseId);
+					}
+				}
+				this->incommingBegin_[nNeurons] = static_cast<SynapseId>(this->incommingSynapses_.size());
+			}
+
+			//=================================================================
+			// access by synapse id
+
+			// return the id of the synapse from origin to destination, NO_SYNAPSE if it does not exist. Logarithmic in the number of outgoing synapses.
+			SynapseId getSynapseId(const NeuronId origin, const NeuronId destination) const
+			{
+				const SynapseId * const begin = this->outgoingByDestination_.data() + this->outgoingBegin_[origin];
+				const SynapseId * const end = this->outgoingByDestination_.data() + this->outgoingBegin_[origin + 1];
+				const SynapseId * const it = std::lower_bound(begin, end, destination, [this](const SynapseId synapseId, const NeuronId d) { return this->destination_[synapseId] < d; });
+				return ((it != end) && (this->destination_[*it] == destination)) ? *it : NO_SYNAPSE;
+			}
+
+			NeuronId getOrigin(const SynapseId synapseId) const
+			{
+				return this->origin_[synapseId];
+			}
+
+			NeuronId getDestination(const SynapseId synapseId) const
+			{
+				return this->destination_[synapseId];
+			}
+
+			SynapseIdRange getOutgoingSynapses(const NeuronId origin) const
+			{
+				return SynapseIdRange(this->outgoingBegin_[origin], this->outgoingBegin_[origin + 1]);
+			}
+
+			// return the outgoing synapses of the provided origin grouped by delay, in increasing delay
+			const std::vector<DelayGroup>& getOutgoingDelayGroups(const NeuronId origin) const
+			{
+				return this->delayGroups_[origin];
+			}
+
+			// return the outgoing synapses of the provided origin in the provided delay group
+			SynapseIdRange getOutgoingSynapses(const NeuronId origin, const DelayGroup& delayGroup) const
+			{
+				const SynapseId begin = this->outgoingBegin_[origin];
+				return SynapseIdRange(begin + delayGroup.begin, begin + delayGroup.end);
+			}
+
+			SynapseIdSpan getIncommingSynapses(const NeuronId destination) const
+			{
+				const SynapseId * const data = this->incommingSynapses_.data();
+				return SynapseIdSpan(data + this->incommingBegin_[destination], data + this->incommingBegin_[destination + 1]);
+			}
+
+			float getWeight(const SynapseId synapseId) const
+			{
+				return this->synapses_[synapseId].weight;
+			}
+
+			void setWeight(const SynapseId synapseId, const float value)
+			{
+				this->synapses_[synapseId].weight = value;
+			}
+
+			void incWeight(const SynapseId synapseId, const float value)
+			{
+				float& weight = this->synapses_[synapseId].weight;
+				weight = clampWeight(weight + value);
+			}
+
+			void decWeight(const SynapseId synapseId, const float value)
+			{
+				float& weight = this->synapses_[synapseId].weight;
+				weight = clampWeight(weight - value);
+			}
+
+			// the weight changes with Options::deferWeightUpdates: the change is accumulated and applied by flushWeightDeltas
+			void incWeightDeferred(const SynapseId synapseId, const float value)
+			{
+				this->markChanged(synapseId, value);
+				this->wd_plus_[synapseId] += value;
+			}
+
+			void decWeightDeferred(const SynapseId synapseId, const float value)
+			{
+				this->markChanged(synapseId, value);
+				this->wd_min_[synapseId] += value;
+			}
+
+			// apply the accumulated weight changes, clamped once, and reset them. Only the synapses changed since the last flush
+			// are visited; the other synapses are left untouched (inhibitory weights are outside the clamp range).
+			void flushWeightDeltas()
+			{
+				for (const SynapseId synapseId : this->changedSynapses_)
+				{
+					float& weight = this->synapses_[synapseId].weight;
+					weight = std::min(static_cast<float>(Options::maxExcWeight), std::max(static_cast<float>(Options::minExcWeight), weight + this->wd_plus_[synapseId] - this->wd_min_[synapseId]));
+					this->wd_plus_[synapseId] = 0;
+					this->wd_min_[synapseId] = 0;
+				}
+				this->changedSynapses_.clear();
+			}
+
+			KernelTime getDelay(const SynapseId synapseId) const
+			{
+				return this->synapses_[synapseId].delay;
+			}
+
+			KernelTime getLastDeliverTime(const SynapseId synapseId) const
+			{
+				return this->synapses_[synapseId].getLastDeliverTime();
+			}
+
+			void setLastDeliverTime(const SynapseId synapseId, const KernelTime t)
+			{
+				this->synapses_[synapseId].setLastDeliverTime(t);
+			}
+
+			//=================================================================
+			// access by origin and destination; these are not used in the simulation loop
+
+			float getWeight(const NeuronId origin, const NeuronId destination) const
+			{
+				return this->getWeight(this->checkedSynapseId(origin, destination));
+			}
+
+			KernelTime getDelay(const NeuronId origin, const NeuronId destination) const
+			{
+				return this->getDelay(this->checkedSynapseId(origin, destination));
+			}
+
+			// return the number of bytes allocated
+			size_t getMemoryUsage() const
+			{
+				size_t result = 0;
+				for (const std::vector<DelayGroup>& delayGroups : this->delayGroups_)
+				{
+					result += delayGroups.capacity() * sizeof(DelayGroup);
+				}
+				return result
+					+ (this->synapses_.capacity() * sizeof(Synapse))
+					+ (this->wd_plus_.capacity() * sizeof(float))
+					+ (this->wd_min_.capacity() * sizeof(float))
+					+ (this->changedSynapses_.capacity() * sizeof(SynapseId))
+					+ (this->origin_.capacity() * sizeof(NeuronId))
+					+ (this->destination_.capacity() * sizeof(NeuronId))
+					+ (this->outgoingByDestination_.capacity() * sizeof(SynapseId))
+					+ (this->outgoingBegin_.capacity() * sizeof(SynapseId))
+					+ (this->incommingBegin_.capacity() * sizeof(SynapseId))
+					+ (this->incommingSynapses_.capacity() * sizeof(SynapseId));
+			}
+
+		private:
+
+			// the data that is used together in fire() is stored together
+			struct SynapsePlastic
+			{
+				float weight;
+				KernelTime delay;
+				KernelTime lastDeliverTime;
+
+				SynapsePlastic(const float weight, const KernelTime delay)
+					: weight(weight)
+					, delay(delay)
+					, lastDeliverTime(-1000 * Options::nSubMs)
+				{
+				}
+
+				KernelTime getLastDeliverTime() const { return this->lastDeliverTime; }
+				void setLastDeliverTime(const KernelTime t) { this->lastDeliverTime = t; }
+			};
+
+			// with Options::inferenceOnly there is no last deliver time; it is never read
+			struct SynapseFrozen
+			{
+				float weight;
+				KernelTime delay;
+
+				SynapseFrozen(const float weight, const KernelTime delay)
+					: weight(weight)
+					, delay(delay)
+				{
+				}
+
+				KernelTime getLastDeliverTime() const { return NO_KERNEL_TIME; }
+				void setLastDeliverTime(const KernelTime /*t*/) {}
+			};
+
+			using Synapse = typename std::conditional<Options::inferenceOnly, SynapseFrozen, SynapsePlastic>::type;
+
+			std::vector<Synapse> synapses_;
+			std::vector<float> wd_plus_; // deferred weight increases, see flushWeightDeltas
+			std::vector<float> wd_min_; // deferred weight decreases, see flushWeightDeltas
+			std::vector<SynapseId> changedSynapses_; // the synapses with a deferred change, see markChanged
+			std::vector<NeuronId> origin_;
+			std::vector<NeuronId> destination_;
+			std::vector<SynapseId> outgoingByDestination_; // per origin, the outgoing synapse ids sorted by destination
+
+			std::vector<SynapseId> outgoingBegin_; // the outgoing synapses of neuron i are [outgoingBegin_[i], outgoingBegin_[i+1])
+			std::vector<SynapseId> incommingBegin_; // the incomming synapses of neuron i are incommingSynapses_[incommingBegin_[i] .. incommingBegin_[i+1]]
+			std::vector<SynapseId> incommingSynapses_;
+			std::vector<std::vector<DelayGroup>> delayGroups_;
+
+			SynapseId checkedSynapseId(const NeuronId origin, const NeuronId destination) const
+			{
+				const SynapseId synapseId = this->getSynapseId(origin, destination);
+				::tools::assert::assert_msg(synapseId != NO_SYNAPSE, "synapse does not exist: origin=", origin, "; destination=", destination);
+				return synapseId;
+			}
+
+			// remember the synapse at its first non-zero change since the last flush
+			void markChanged(const SynapseId synapseId, const float value)
+			{
+				if ((value != 0) && (this->wd_plus_[synapseId] == 0) && (this->wd_min_[synapseId] == 0))
+				{
+					this->changedSynapses_.push_back(synapseId);
+				}
+			}
+
+			static float clampWeight(const float weight)
+			{
+				if (weight > Options::maxExcWeight)
+				{
+					return Options::maxExcWeight;
+				}
+				else if (weight < Options::minExcWeight)
+				{
+					return Options::minExcWeight;
+				}
+				return weight;
+			}
+		};
+	}
+}
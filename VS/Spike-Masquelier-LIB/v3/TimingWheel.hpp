@@ -0,0 +1,186 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>	// std::fill
+
+#include "../../Spike-Tools-LIB/assert.ipp"
+
+#include "Types.hpp"
+#include "NeuronBitSet.hpp"	// countTrailingZeros
+
+namespace spike
+{
+	namespace v3
+	{
+		// Calendar queue with one slot per kernel time. An element scheduled at kerneltime t is stored in slot (t mod nSlots),
+		// hence all scheduled elements have to be within nSlots of the oldest not yet retrieved slot. A bitmap with one bit per
+		// slot marks the slots that are not empty, such that the next element is found 64 slots at a time.
+		template <typename Element>
+		class TimingWheel
+		{
+		public:
+
+			// constructor: the number of slots is rounded up to a power of two such that the slot can be found with a mask.
+			TimingWheel(const size_t minNumberOfSlots)
+				: nSlots_(roundUpToPowerOfTwo(minNumberOfSlots))
+				, mask_(roundUpToPowerOfTwo(minNumberOfSlots) - 1)
+				, slots_(std::vector<std::vector<Element>>(roundUpToPowerOfTwo(minNumberOfSlots)))
+				, occupied_(std::vector<std::uint64_t>((roundUpToPowerOfTwo(minNumberOfSlots) + 63) / 64, 0))
+				, size_(0)
+			{
+			}
+
+			size_t getNumberOfSlots() const
+			{
+				return this->nSlots_;
+			}
+
+			// return the number of scheduled elements
+			size_t size() const
+			{
+				return this->size_;
+			}
+
+			bool empty() const
+			{
+				return this->size_ == 0;
+			}
+
+			void add(const KernelTime kerneltime, const Element& element)
+			{
+				::tools::assert::assert_msg(kerneltime >= 0, "spike::v3::TimingWheel::add: negative kerneltime ", kerneltime);
+				const size_t slot = this->slotIndex(kerneltime);
+				this->slots_[slot].push_back(element);
+				this->occupied_[slot >> 6] |= (static_cast<std::uint64_t>(1) << (slot & 63));
+				this->size_++;
+			}
+
+			// return the elements in the slot of the provided kerneltime; the elements are in the order they were added.
+			const std::vector<Element>& getSlot(const KernelTime kerneltime) const
+			{
+				return this->slots_[this->slotIndex(kerneltime)];
+			}
+
+			// remove the elements in the slot of the provided kerneltime, the capacity of the slot is retained.
+			void clearSlot(const KernelTime kerneltime)
+			{
+				const size_t index = this->slotIndex(kerneltime);
+				std::vector<Element>& slot = this->slots_[index];
+				this->size_ -= slot.size();
+				slot.clear();
+				this->occupied_[index >> 6] &= ~(static_cast<std::uint64_t>(1) << (index & 63));
+			}
+
+			void clear()
+			{
+				for (std::vector<Element>& slot : this->slots_)
+				{
+					slot.clear();
+				}
+				std::fill(this->occupied_.begin(), this->occupied_.end(), 0);
+				this->size_ = 0;
+			}
+
+			// return the first kerneltime at or after the provided time whose slot is not empty, LAST_KERNEL_TIME if the wheel is
+			// empty; the provided time has to be the oldest not yet retrieved slot, such that the slots are visited in time order
+			KernelTime getNextOccupiedTime(const KernelTime kerneltime) const
+			{
+				if (this->size_ == 0) return LAST_KERNEL_TIME;
+
+				const size_t startSlot = this->slotIndex(kerneltime);
+				const size_t nWords = this->occupied_.size();
+				const size_t startWord = startSlot >> 6;
+
+				// the start word is visited twice: first its slots at or after the start slot, at the end (after wrapping around) the slots before it
+				for (size_t i = 0; i <= nWords; ++i)
+				{
+					const size_t wordIndex = (startWord + i) % nWords;
+					std::uint64_t word = this->occupied_[wordIndex];
+					if (i == 0)
+					{
+						word &= ~static_cast<std::uint64_t>(0) << (startSlot & 63);
+					}
+					else if (i == nWords)
+					{
+						word &= ~(~static_cast<std::uint64_t>(0) << (startSlot & 63));
+					}
+					if (word != 0)
+					{
+						const size_t slot = (wordIndex << 6) + countTrailingZeros(word);
+						return kerneltime + static_cast<KernelTime>((slot - startSlot) & this->mask_);
+					}
+				}
+				return LAST_KERNEL_TIME;
+			}
+
+			// return a copy of all scheduled elements, in no particular order
+			std::vector<Element> getAll() const
+			{
+				std::vector<Element> result;
+				result.reserve(this->size_);
+				for (const std::vector<Element>& slot : this->slots_)
+				{
+					result.insert(result.end(), slot.begin(), slot.end());
+				}
+				return result;
+			}
+
+			// return the number of bytes allocated by the slots
+			size_t getMemoryUsage() const
+			{
+				size_t result = this->slots_.capacity() * sizeof(std::vector<Element>);
+				for (const std::vector<Element>& slot : this->slots_)
+				{
+					result += slot.capacity() * sizeof(Element);
+				}
+				return result;
+			}
+
+		private:
+
+			const size_t nSlots_;
+			const size_t mask_;
+			std::vector<std::vector<Element>> slots_;
+			std::vector<std::uint64_t> occupied_; // bit (slot mod 64) of word (slot / 64) is set when the slot is not empty
+			size_t size_;
+
+			size_t slotIndex(const KernelTime kerneltime) const
+			{
+				return static_cast<size_t>(kerneltime) & this->mask_;
+			}
+
+			static size_t roundUpToPowerOfTwo(const size_t i)
+			{
+				size_t result = 1;
+				while (result < i)
+				{
+					result <<= 1;
+				}
+				return result;
+			}
+		};
+	}
+}
@@ -90,6 +90,11 @@ namespace spike
 				return v;
 			}
 
+			const std::vector<Pathway>& getPathways() const
+			{
+				return this->pathways_;
+			}
+
 			void clearPathways()
 			{
 				this->pathways_.clear();
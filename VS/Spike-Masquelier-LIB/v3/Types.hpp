@@ -23,6 +23,7 @@
 #pragma once
 
 #include <string>
+#include <cstdint>		// std::uint8_t
 #include <limits>		// std::numeric_limits
 #include <sstream>		// std::ostringstream
 #include <iostream>		// std::cout, std::fixed
@@ -40,12 +41,51 @@ namespace spike
 		using TimeInSec = unsigned int; // max time is 136.19 year for unsigned int;
 
 		using Delay = unsigned int;
+		using SynapseId = unsigned int;
 		using Efficacy = float;
 		using Voltage = float;
 
 		const KernelTime LAST_KERNEL_TIME = std::numeric_limits<KernelTime>::max();
 		const KernelTime NO_KERNEL_TIME = std::numeric_limits<KernelTime>::max();
 		const NeuronId NO_NEURON = std::numeric_limits<NeuronId>::max();
+		const SynapseId NO_SYNAPSE = std::numeric_limits<SynapseId>::max();
+
+		// how Network3 computes the epsilon part of the membrane potential
+		enum class VoltageEngine : std::uint8_t
+		{
+			TABLE_SUM = 0, // sum of efficacy * cachedEpsilon over all incomming spikes of the last kernelRangeEpsilonInMs
+			EXPONENTIAL_STATE = 1 // two decaying state variables per neuron, see ExponentialVoltageState
+		};
+
+		// how Network3 draws the time of the next random (background) spike of a neuron
+		enum class RandomSpikeGenerator : std::uint8_t
+		{
+			GLOBAL_RAND = 0, // the global rand(), as in the original code; the drawn times depend on the order in which the neurons draw
+			COUNTER_BASED = 1 // a stream per neuron derived from Options::randomSeed, see CounterBasedRandom; independent of the order and of other networks
+		};
+
+		// how Network3 finds the synapses that get LTP when a neuron fires
+		enum class PlasticityEngine : std::uint8_t
+		{
+			PAIR_SCAN = 0, // compare the last deliver time of all incomming synapses of the neuron with the fire time
+			RECENT_DELIVERIES = 1 // only visit the synapses that delivered a spike within kernelRangeStdpInMs, see RecentDeliveries
+		};
+
+		// when Network3 ends the presentation of a case before its duration plus tail silence, checked at the end of every window
+		enum class DecisionPolicy : std::uint8_t
+		{
+			NONE = 0, // present the full case
+			FIRST_SPIKES = 1, // decide for the first motor neuron that has fired decisionSpikes propagated spikes in the case
+			MARGIN = 2 // decide for the motor neuron with the most propagated spikes when it leads the second by decisionSpikes
+		};
+
+		// how MnistSpikeSource translates the intensity of a pixel (0..255) into spike times
+		enum class SpikeEncoding : std::uint8_t
+		{
+			THRESHOLD = 0, // as TranslationsFactory::createMnistTranslations: one spike at a random time per pixel when the pixel is at least 170
+			RATE = 1, // a number of spikes proportional to the intensity, evenly spaced from a random time per pixel
+			LATENCY = 2 // one spike, earlier for a brighter pixel; no spike for a black pixel
+		};
 
 		struct IncommingSpike
 		{
@@ -76,6 +116,24 @@ namespace spike
 			{
 			}
 
+			// accessors shared with PackedIncommingSpike, the record of IncommingSpikeStore; the time of an IncommingSpike is absolute
+			static const bool hasBaseTime = false;
+
+			KernelTime getKernelTime(const KernelTime /*baseTime*/) const
+			{
+				return this->kerneltime;
+			}
+
+			NeuronId getOrigin() const
+			{
+				return this->origin;
+			}
+
+			Efficacy getEfficacy() const
+			{
+				return this->efficacy;
+			}
+
 			bool operator< (const IncommingSpike& spike) const
 			{
 				if (this->kerneltime < spike.kerneltime)
@@ -119,6 +177,22 @@ namespace spike
 			}
 		};
 
+		// spike of a sensor neuron at offset kernel time after the start of its case, see SpikeCase::compileEvents
+		struct SensorEvent
+		{
+			KernelTime offset;
+			NeuronId neuronId;
+
+			// constructor
+			SensorEvent(
+				const KernelTime offset,
+				const NeuronId neuronId
+			): offset(offset)
+				, neuronId(neuronId)
+			{
+			}
+		};
+
 		class CompareIncommingSpike
 		{
 		public:
@@ -128,6 +202,76 @@ namespace spike
 			}
 		};
 
+		// range of consecutive synapse ids [begin, end)
+		class SynapseIdRange
+		{
+		public:
+
+			class iterator
+			{
+			public:
+				iterator(const SynapseId i) : i_(i) {}
+				SynapseId operator*() const { return this->i_; }
+				iterator& operator++() { ++this->i_; return *this; }
+				bool operator!=(const iterator& other) const { return this->i_ != other.i_; }
+			private:
+				SynapseId i_;
+			};
+
+			SynapseIdRange(const SynapseId begin, const SynapseId end)
+				: begin_(begin)
+				, end_(end)
+			{
+			}
+
+			iterator begin() const { return iterator(this->begin_); }
+			iterator end() const { return iterator(this->end_); }
+			size_t size() const { return this->end_ - this->begin_; }
+
+		private:
+			const SynapseId begin_;
+			const SynapseId end_;
+		};
+
+		// range of synapse ids stored in an array
+		class SynapseIdSpan
+		{
+		public:
+
+			SynapseIdSpan(const SynapseId * const begin, const SynapseId * const end)
+				: begin_(begin)
+				, end_(end)
+			{
+			}
+
+			const SynapseId * begin() const { return this->begin_; }
+			const SynapseId * end() const { return this->end_; }
+			size_t size() const { return this->end_ - this->begin_; }
+
+		private:
+			const SynapseId * const begin_;
+			const SynapseId * const end_;
+		};
+
+		// the outgoing synapses of a neuron with the same delay: the positions [begin, end) in the outgoing synapses of the neuron
+		struct DelayGroup
+		{
+			KernelTime delay;
+			unsigned int begin;
+			unsigned int end;
+
+			// constructor
+			DelayGroup(
+				const KernelTime delay,
+				const unsigned int begin,
+				const unsigned int end
+			): delay(delay)
+				, begin(begin)
+				, end(end)
+			{
+			}
+		};
+
 		struct PostSynapticSpike
 		{
 			KernelTime kerneltime;
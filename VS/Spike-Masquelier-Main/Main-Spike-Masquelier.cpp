@@ -68,10 +68,15 @@
 #include "../Spike-Masquelier-LIB/v0/SpikeEpspContainer.hpp"
 
 #include "../Spike-Masquelier-LIB/v3/Network3.hpp"
+#include "../Spike-Masquelier-LIB/v3/IncommingSpikeQueueCalendar.hpp"
+#include "../Spike-Masquelier-LIB/v3/SynapsesSparse.hpp"
 #include "../Spike-Masquelier-LIB/v3/SpikeOptionsStatic.hpp"
 #include "../Spike-Masquelier-LIB/v3/SpikeCase.hpp"
 #include "../Spike-Masquelier-LIB/v3/SpikeStreamDataSet.hpp"
+#include "../Spike-Masquelier-LIB/v3/SpikeDataSetBinary.hpp"
+#include "../Spike-Masquelier-LIB/v3/MnistSpikeSource.hpp"
 #include "../Spike-Masquelier-LIB/v3/SpikeStreamMatlab.hpp"
+#include "../Spike-Masquelier-LIB/v3/BatchEvaluator.hpp"
 #include "../Spike-Masquelier-LIB/v3/Experiments.hpp"
 
 
@@ -198,6 +203,83 @@ namespace spike {
 		return spikeStream;
 	}
 
+	// stream with the MNIST cases encoded on the fly from the IDX files, instead of a SpikeDataSet file
+	template <typename Topology>
+	std::shared_ptr<v3::SpikeStreamDataSet<Topology>> createMnistSpikeStreamOnline(
+		const v0::SpikeRuntimeOptions& SpikeRuntimeOptions,
+		const v3::SpikeEncoding spikeEncoding)
+	{
+		using Options = Topology::Options;
+
+		const auto spikeStream = std::make_shared<v3::SpikeStreamDataSet<Topology>>(SpikeRuntimeOptions);
+
+		std::vector<NeuronId> neuronIds;
+		for (const NeuronId& neuronId : Topology::iterator_AllNeurons()) {
+			neuronIds.push_back(neuronId);
+		}
+
+		//1] create one random case
+		const auto spikeCase = std::make_shared<v3::SpikeCase<Options>>(v3::SpikeCase<Options>(CaseId(0), NO_CASE_LABEL, neuronIds, SpikeRuntimeOptions.getRandomCaseDurationInMs(), 0));
+		spikeCase->setAllNeuronsRandomSpikeHz(SpikeRuntimeOptions.getRandomSpikeHz());
+		spikeStream->add(std::move(spikeCase));
+
+		//2] encode the regular cases on a producer thread
+		const std::string imagesFilename = sourceDir + "/../mnist data/train-images.idx3-ubyte";
+		const std::string labelsFilename = sourceDir + "/../mnist data/train-labels.idx1-ubyte";
+		const unsigned int maxSpikesPerPixel = 4;
+		const size_t lookAhead = 256;
+		spikeStream->setCaseSource(std::make_shared<v3::MnistSpikeSource<Options>>(imagesFilename, labelsFilename, SpikeRuntimeOptions, spikeEncoding, maxSpikesPerPixel, lookAhead));
+		return spikeStream;
+	}
+
+	template <typename Topology>
+	std::shared_ptr<v3::SpikeStreamDataSet<Topology>> createRandomSpikeStream(
+		const v0::SpikeRuntimeOptions& SpikeRuntimeOptions)
+	{
+		using Options = Topology::Options;
+
+		const auto spikeStream = std::make_shared<v3::SpikeStreamDataSet<Topology>>(SpikeRuntimeOptions);
+
+		std::vector<NeuronId> neuronIds;
+		for (const NeuronId& neuronId : Topology::iterator_AllNeurons()) {
+			neuronIds.push_back(neuronId);
+		}
+		const v3::TimeInMs caseTailSilence = 0;
+		const v3::TimeInMs randomCaseDuration = SpikeRuntimeOptions.getRandomCaseDurationInMs();
+		const auto spikeCase = std::make_shared<v3::SpikeCase<Options>>(v3::SpikeCase<Options>(CaseId(0), NO_CASE_LABEL, neuronIds, randomCaseDuration, caseTailSilence));
+		spikeCase->setAllNeuronsRandomSpikeHz(SpikeRuntimeOptions.getRandomSpikeHz());
+		spikeStream->add(std::move(spikeCase));
+		return spikeStream;
+	}
+
+	// restart rand() and the random generator of the tools (used by init_mnist and the case selection), such that every
+	// run of a benchmark simulates the same network
+	void resetRandomGenerators()
+	{
+		srand(123456789);
+		::tools::random::set_seed(0xACE1ACE1);
+	}
+
+	// the runtime options of the v3 benchmarks: as testNetworkV3_mnist, without dumps
+	v0::SpikeRuntimeOptions createBenchmarkRuntimeOptions()
+	{
+		auto spikeRuntimeOptions = v0::SpikeRuntimeOptions();
+
+		spikeRuntimeOptions.setCaseDurationInMs(0);
+		spikeRuntimeOptions.setCaseTailSilenceInMs(100);
+
+		spikeRuntimeOptions.setRefractoryPeriodInMs(5);
+		spikeRuntimeOptions.setRandomCaseDurationInMs(500);
+		spikeRuntimeOptions.setRandomSpikeHz(1);
+		spikeRuntimeOptions.setCorrectNeuronSpikeHz(2);
+
+		spikeRuntimeOptions.setDumpIntervalInSec_Spikes(0);
+		spikeRuntimeOptions.setDumpIntervalInSec_State(0);
+		spikeRuntimeOptions.setDumpIntervalInSec_Topology(0);
+		spikeRuntimeOptions.setDumpIntervalInSec_Group(0);
+		return spikeRuntimeOptions;
+	}
+
 	template <typename Topology>
 	std::shared_ptr<spike::v3::SpikeStreamMatlab<Topology>> loadMasquelierMatlabSpikeStream(
 		const v0::SpikeRuntimeOptions& SpikeRuntimeOptions)
@@ -414,6 +496,578 @@ namespace spike {
 		net.mainLoop(nSeconds, useConfusionMatrix);
 	}
 
+	void testNetworkV3_mnist_threadScaling()
+	{
+		printf("Running spike network testNetworkV3_mnist_threadScaling\n");
+
+		const auto spikeRuntimeOptions = createBenchmarkRuntimeOptions();
+
+		const size_t Ne = 800;
+		const size_t Ni = 200;
+		const size_t Ns = 28 * 28;
+		const size_t Nm = 10;
+
+		using Options = spike::v3::SpikeOptionsStatic<Ne, Ni, Ns, Nm>;
+		using Top = spike::v3::Topology<Options>;
+		using SpikeStream = spike::v3::SpikeStreamDataSet<Top>;
+
+		const unsigned int nSeconds = 10;
+		const bool useConfusionMatrix = false;
+		const std::vector<int> nThreadsList = { 1, 2, 4, 8, 16 };
+
+		double wallTime1Thread = 0;
+		unsigned long long weightHash1Thread = 0;
+
+		for (const int nThreads : nThreadsList)
+		{
+			// every run starts from the same random state, such that all runs simulate the same network
+			resetRandomGenerators();
+
+			Options staticOptions = Options();
+			auto topology = std::make_shared<Top>();
+			topology->init_mnist();
+
+			spike::v3::Network3<Top, SpikeStream> net(staticOptions, spikeRuntimeOptions);
+			net.setTopology(topology);
+			net.setSpikeStream(loadMnistSpikeStream<Top>(spikeRuntimeOptions));
+			net.setNumberOfThreads(nThreads);
+
+			const auto t1 = std::chrono::steady_clock::now();
+			net.mainLoop(nSeconds, useConfusionMatrix);
+			const auto t2 = std::chrono::steady_clock::now();
+
+			const double wallTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+			const unsigned long long weightHash = net.getWeightHash();
+			if (nThreads == nThreadsList.front())
+			{
+				wallTime1Thread = wallTime;
+				weightHash1Thread = weightHash;
+			}
+			printf("spike::testNetworkV3_mnist_threadScaling: %2d threads: %8.0f ms wall; speedup %5.2f; weight hash %016llx\n", nThreads, wallTime, wallTime1Thread / wallTime, weightHash);
+			if (weightHash != weightHash1Thread)
+			{
+				std::cerr << "spike::testNetworkV3_mnist_threadScaling: ERROR: the weights with " << nThreads << " threads differ from the weights with " << nThreadsList.front() << " thread" << std::endl;
+				throw std::runtime_error("the network depends on the number of threads");
+			}
+		}
+	}
+
+	// the result of runSpikeQueueBenchmark
+	struct BenchmarkRun
+	{
+		double wallTimeInMs;
+		double maxVoltageDeviation; // max deviation of the voltage with the exact kernel sum over the run; zero without Options::checkVoltageEngine
+		unsigned long long weightHash; // hash of all weights after the run
+	};
+
+	// run the network for the provided number of seconds
+	template <typename Top, typename SpikeQueue, typename Synapses = spike::v3::Synapses<Top>>
+	BenchmarkRun runSpikeQueueBenchmark(
+		const v0::SpikeRuntimeOptions& spikeRuntimeOptions,
+		const bool useMnist,
+		const unsigned int nSeconds)
+	{
+		using Options = typename Top::Options;
+		using SpikeStream = spike::v3::SpikeStreamDataSet<Top>;
+
+		resetRandomGenerators();
+
+		Options staticOptions = Options();
+		auto topology = std::make_shared<Top>();
+		if (useMnist) {
+			topology->init_mnist();
+		} else {
+			topology->init_Izhikevich();
+		}
+
+		spike::v3::Network3<Top, SpikeStream, SpikeQueue, Synapses> net(staticOptions, spikeRuntimeOptions);
+		net.setTopology(topology);
+		if (useMnist) {
+			net.setSpikeStream(loadMnistSpikeStream<Top>(spikeRuntimeOptions));
+		} else {
+			net.setSpikeStream(createRandomSpikeStream<Top>(spikeRuntimeOptions));
+		}
+
+		const auto t1 = std::chrono::steady_clock::now();
+		net.mainLoop(nSeconds, false);
+		const auto t2 = std::chrono::steady_clock::now();
+		BenchmarkRun result;
+		result.wallTimeInMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+		result.maxVoltageDeviation = net.getMaxVoltageDeviation();
+		result.weightHash = net.getWeightHash();
+		return result;
+	}
+
+	void testNetworkV3_spikeQueueBenchmark()
+	{
+		printf("Running spike network testNetworkV3_spikeQueueBenchmark\n");
+
+		const auto spikeRuntimeOptions = createBenchmarkRuntimeOptions();
+
+		const unsigned int nSeconds = 10;
+
+		{
+			using Options = spike::v3::SpikeOptionsStatic<800, 200, 0, 0>;
+			using Top = spike::v3::Topology<Options>;
+			const double t1 = runSpikeQueueBenchmark<Top, spike::v3::IncommingSpikeQueue<Top>>(spikeRuntimeOptions, false, nSeconds).wallTimeInMs;
+			const double t2 = runSpikeQueueBenchmark<Top, spike::v3::IncommingSpikeQueueCalendar<Top>>(spikeRuntimeOptions, false, nSeconds).wallTimeInMs;
+			const double t3 = runSpikeQueueBenchmark<Top, spike::v3::IncommingSpikeQueueCalendar<Top>, spike::v3::SynapsesSparse<Top>>(spikeRuntimeOptions, false, nSeconds).wallTimeInMs;
+			printf("spike::testNetworkV3_spikeQueueBenchmark: Izhikevich: IncommingSpikeQueue %8.0f ms wall; IncommingSpikeQueueCalendar %8.0f ms wall; IncommingSpikeQueueCalendar+SynapsesSparse %8.0f ms wall\n", t1, t2, t3);
+		}
+		{
+			using Options = spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>;
+			using Top = spike::v3::Topology<Options>;
+			const double t1 = runSpikeQueueBenchmark<Top, spike::v3::IncommingSpikeQueue<Top>>(spikeRuntimeOptions, true, nSeconds).wallTimeInMs;
+			const double t2 = runSpikeQueueBenchmark<Top, spike::v3::IncommingSpikeQueueCalendar<Top>>(spikeRuntimeOptions, true, nSeconds).wallTimeInMs;
+			const double t3 = runSpikeQueueBenchmark<Top, spike::v3::IncommingSpikeQueueCalendar<Top>, spike::v3::SynapsesSparse<Top>>(spikeRuntimeOptions, true, nSeconds).wallTimeInMs;
+			printf("spike::testNetworkV3_spikeQueueBenchmark: MNIST: IncommingSpikeQueue %8.0f ms wall; IncommingSpikeQueueCalendar %8.0f ms wall; IncommingSpikeQueueCalendar+SynapsesSparse %8.0f ms wall\n", t1, t2, t3);
+		}
+	}
+
+	// options for the exponential-state voltage engine; the members of SpikeOptionsStatic are overridden by hiding them
+	struct SpikeOptionsExponentialState : spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>
+	{
+		static const spike::v3::VoltageEngine voltageEngine = spike::v3::VoltageEngine::EXPONENTIAL_STATE;
+	};
+
+	struct SpikeOptionsExponentialStateChecked : spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>
+	{
+		static const spike::v3::VoltageEngine voltageEngine = spike::v3::VoltageEngine::EXPONENTIAL_STATE;
+		static const bool checkVoltageEngine = true;
+	};
+
+	struct SpikeOptionsTableSumChecked : spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>
+	{
+		static const bool checkVoltageEngine = true;
+	};
+
+	void testNetworkV3_voltageEngineBenchmark()
+	{
+		printf("Running spike network testNetworkV3_voltageEngineBenchmark\n");
+
+		const auto spikeRuntimeOptions = createBenchmarkRuntimeOptions();
+
+		const unsigned int nSeconds = 10;
+
+		using Top1 = spike::v3::Topology<spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>>;
+		using Top2 = spike::v3::Topology<SpikeOptionsExponentialState>;
+		using Top3 = spike::v3::Topology<SpikeOptionsTableSumChecked>;
+		using Top4 = spike::v3::Topology<SpikeOptionsExponentialStateChecked>;
+
+		// all runs start from the same random state; the checked runs compute the exact kernel sum next to the engine, hence
+		// the wall time is taken from the unchecked runs
+		const BenchmarkRun run1 = runSpikeQueueBenchmark<Top1, spike::v3::IncommingSpikeQueue<Top1>>(spikeRuntimeOptions, true, nSeconds);
+		const BenchmarkRun run2 = runSpikeQueueBenchmark<Top2, spike::v3::IncommingSpikeQueue<Top2>>(spikeRuntimeOptions, true, nSeconds);
+		const BenchmarkRun run3 = runSpikeQueueBenchmark<Top3, spike::v3::IncommingSpikeQueue<Top3>>(spikeRuntimeOptions, true, nSeconds);
+		const BenchmarkRun run4 = runSpikeQueueBenchmark<Top4, spike::v3::IncommingSpikeQueue<Top4>>(spikeRuntimeOptions, true, nSeconds);
+		printf("spike::testNetworkV3_voltageEngineBenchmark: MNIST: TABLE_SUM %8.0f ms wall; max |dV| with exact kernel sum %e\n", run1.wallTimeInMs, run3.maxVoltageDeviation);
+		printf("spike::testNetworkV3_voltageEngineBenchmark: MNIST: EXPONENTIAL_STATE %8.0f ms wall; max |dV| with exact kernel sum %e\n", run2.wallTimeInMs, run4.maxVoltageDeviation);
+	}
+
+	template <typename Options_i>
+	struct SpikeOptionsSkipSilentWindows : Options_i
+	{
+		static const bool useVoltageUpperBound = true;
+		static const bool useActiveNeuronSet = true;
+		static const bool skipSilentWindows = true;
+	};
+
+	// skipping the silent windows (with the two options it requires) may not change the network: run with and without it
+	// from the same random state and compare the weights
+	void testNetworkV3_skipSilentWindowsBenchmark()
+	{
+		printf("Running spike network testNetworkV3_skipSilentWindowsBenchmark\n");
+
+		const auto spikeRuntimeOptions = createBenchmarkRuntimeOptions();
+
+		const unsigned int nSeconds = 10;
+
+		using Options1 = spike::v3::SpikeOptionsStatic<800, 200, 0, 0>;
+		using Options2 = spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>;
+		using Top1 = spike::v3::Topology<Options1>;
+		using Top2 = spike::v3::Topology<SpikeOptionsSkipSilentWindows<Options1>>;
+		using Top3 = spike::v3::Topology<Options2>;
+		using Top4 = spike::v3::Topology<SpikeOptionsSkipSilentWindows<Options2>>;
+
+		const BenchmarkRun run1 = runSpikeQueueBenchmark<Top1, spike::v3::IncommingSpikeQueue<Top1>>(spikeRuntimeOptions, false, nSeconds);
+		const BenchmarkRun run2 = runSpikeQueueBenchmark<Top2, spike::v3::IncommingSpikeQueue<Top2>>(spikeRuntimeOptions, false, nSeconds);
+		const BenchmarkRun run3 = runSpikeQueueBenchmark<Top3, spike::v3::IncommingSpikeQueue<Top3>>(spikeRuntimeOptions, true, nSeconds);
+		const BenchmarkRun run4 = runSpikeQueueBenchmark<Top4, spike::v3::IncommingSpikeQueue<Top4>>(spikeRuntimeOptions, true, nSeconds);
+		printf("spike::testNetworkV3_skipSilentWindowsBenchmark: Izhikevich: every window %8.0f ms wall; skipping silent windows %8.0f ms wall; speedup %5.2f\n", run1.wallTimeInMs, run2.wallTimeInMs, run1.wallTimeInMs / run2.wallTimeInMs);
+		printf("spike::testNetworkV3_skipSilentWindowsBenchmark: MNIST: every window %8.0f ms wall; skipping silent windows %8.0f ms wall; speedup %5.2f\n", run3.wallTimeInMs, run4.wallTimeInMs, run3.wallTimeInMs / run4.wallTimeInMs);
+		if ((run1.weightHash != run2.weightHash) || (run3.weightHash != run4.weightHash))
+		{
+			std::cerr << "spike::testNetworkV3_skipSilentWindowsBenchmark: ERROR: skipping the silent windows changes the weights" << std::endl;
+			throw std::runtime_error("skipping the silent windows changes the network");
+		}
+	}
+
+	struct SpikeOptionsRecentDeliveries : spike::v3::SpikeOptionsStatic<800, 200, 0, 0>
+	{
+		static const spike::v3::PlasticityEngine plasticityEngine = spike::v3::PlasticityEngine::RECENT_DELIVERIES;
+	};
+
+	void testNetworkV3_plasticityEngineBenchmark()
+	{
+		printf("Running spike network testNetworkV3_plasticityEngineBenchmark\n");
+
+		const auto spikeRuntimeOptions = createBenchmarkRuntimeOptions();
+
+		const unsigned int nSeconds = 10;
+
+		using Top1 = spike::v3::Topology<spike::v3::SpikeOptionsStatic<800, 200, 0, 0>>;
+		using Top2 = spike::v3::Topology<SpikeOptionsRecentDeliveries>;
+
+		// both engines visit the same synapses, hence the runs are identical except for the wall time
+		const BenchmarkRun run1 = runSpikeQueueBenchmark<Top1, spike::v3::IncommingSpikeQueueCalendar<Top1>, spike::v3::SynapsesSparse<Top1>>(spikeRuntimeOptions, false, nSeconds);
+		const BenchmarkRun run2 = runSpikeQueueBenchmark<Top2, spike::v3::IncommingSpikeQueueCalendar<Top2>, spike::v3::SynapsesSparse<Top2>>(spikeRuntimeOptions, false, nSeconds);
+		printf("spike::testNetworkV3_plasticityEngineBenchmark: Izhikevich: PAIR_SCAN %8.0f ms wall; RECENT_DELIVERIES %8.0f ms wall; speedup %5.2f; weight hash %016llx\n", run1.wallTimeInMs, run2.wallTimeInMs, run1.wallTimeInMs / run2.wallTimeInMs, run1.weightHash);
+		if (run1.weightHash != run2.weightHash)
+		{
+			std::cerr << "spike::testNetworkV3_plasticityEngineBenchmark: ERROR: the weights of RECENT_DELIVERIES (hash " << run2.weightHash << ") differ from the weights of PAIR_SCAN (hash " << run1.weightHash << ")" << std::endl;
+			throw std::runtime_error("the plasticity engines give different weights");
+		}
+	}
+
+	struct SpikeOptionsInferenceOnly : spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>
+	{
+		static const bool inferenceOnly = true;
+		static const spike::v3::RandomSpikeGenerator randomSpikeGenerator = spike::v3::RandomSpikeGenerator::COUNTER_BASED; // required by BatchEvaluator
+	};
+
+	void testNetworkV3_inferenceOnlyBenchmark()
+	{
+		printf("Running spike network testNetworkV3_inferenceOnlyBenchmark\n");
+
+		const auto spikeRuntimeOptions = createBenchmarkRuntimeOptions();
+
+		const unsigned int nSeconds = 10;
+
+		using Top1 = spike::v3::Topology<spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>>;
+		using Top2 = spike::v3::Topology<SpikeOptionsInferenceOnly>;
+
+		// both runs start from the initial weights; the inference run keeps them, hence the spikes differ after the first ms
+		const BenchmarkRun run0 = runSpikeQueueBenchmark<Top1, spike::v3::IncommingSpikeQueueCalendar<Top1>, spike::v3::SynapsesSparse<Top1>>(spikeRuntimeOptions, true, 0);
+		const BenchmarkRun run1 = runSpikeQueueBenchmark<Top1, spike::v3::IncommingSpikeQueueCalendar<Top1>, spike::v3::SynapsesSparse<Top1>>(spikeRuntimeOptions, true, nSeconds);
+		const BenchmarkRun run2 = runSpikeQueueBenchmark<Top2, spike::v3::IncommingSpikeQueueCalendar<Top2>, spike::v3::SynapsesSparse<Top2>>(spikeRuntimeOptions, true, nSeconds);
+		printf("spike::testNetworkV3_inferenceOnlyBenchmark: MNIST: training %6.1f ms wall per simulated second; inference only %6.1f ms wall per simulated second\n", run1.wallTimeInMs / nSeconds, run2.wallTimeInMs / nSeconds);
+		if (run2.weightHash != run0.weightHash)
+		{
+			std::cerr << "spike::testNetworkV3_inferenceOnlyBenchmark: ERROR: the inference only run changed the initial weights" << std::endl;
+			throw std::runtime_error("inferenceOnly changed the weights");
+		}
+	}
+
+	// copy the (trained) pathways into a topology with other static options
+	template <typename Topology2, typename Topology1>
+	std::shared_ptr<Topology2> copyTopology(const std::shared_ptr<const Topology1>& topology1)
+	{
+		auto topology2 = std::make_shared<Topology2>();
+		for (const spike::v3::Pathway& p : topology1->getPathways())
+		{
+			topology2->addPathway(p.origin, p.destination, p.delay, p.efficacy);
+		}
+		return topology2;
+	}
+
+	void testNetworkV3_mnistBatchEvaluation()
+	{
+		printf("Running spike network testNetworkV3_mnistBatchEvaluation\n");
+
+		const auto spikeRuntimeOptions = createBenchmarkRuntimeOptions();
+
+		using Top1 = spike::v3::Topology<spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>>;
+		using Top2 = spike::v3::Topology<SpikeOptionsInferenceOnly>;
+
+		//1] train
+		const unsigned int nSecondsTrain = 1 * 1 * 60;
+		auto topology1 = std::make_shared<Top1>();
+		topology1->init_mnist();
+		spike::v3::Network3<Top1, spike::v3::SpikeStreamDataSet<Top1>, spike::v3::IncommingSpikeQueueCalendar<Top1>, spike::v3::SynapsesSparse<Top1>> net(Top1::Options(), spikeRuntimeOptions);
+		net.setTopology(topology1);
+		net.setSpikeStream(loadMnistSpikeStream<Top1>(spikeRuntimeOptions));
+		net.mainLoop(nSecondsTrain, false);
+
+		//2] evaluate the trained pathways with frozen weights
+		const auto topology2 = copyTopology<Top2>(net.getTopology());
+		const auto cases = loadMnistSpikeStream<Top2>(spikeRuntimeOptions);
+		const spike::v3::BatchEvaluator<Top2, spike::v3::IncommingSpikeQueueCalendar<Top2>, spike::v3::SynapsesSparse<Top2>> evaluator(SpikeOptionsInferenceOnly(), spikeRuntimeOptions, topology2, cases);
+
+		// the cases are independent: every number of threads gives the result of the serial evaluation
+		std::string confusionMatrix1;
+		for (const int nThreads : { 1, 2, 4, 8 })
+		{
+			const std::string confusionMatrix = evaluator.evaluate(nThreads).toStringConfusionMatrix(); // evaluate prints the wall time
+			if (nThreads == 1)
+			{
+				confusionMatrix1 = confusionMatrix;
+				std::cout << confusionMatrix << std::endl;
+			}
+			else if (confusionMatrix != confusionMatrix1)
+			{
+				std::cerr << "spike::testNetworkV3_mnistBatchEvaluation: ERROR: the result with " << nThreads << " threads differs from the result with 1 thread" << std::endl;
+				std::cerr << confusionMatrix1 << std::endl << confusionMatrix << std::endl;
+				throw std::runtime_error("batch evaluation depends on the number of threads");
+			}
+		}
+	}
+
+	// evaluate with more threads than Options::maxNumberOfThreads: the networks of the cases run on one thread each, the
+	// outer team may be larger than their per-thread buffers. The result may not depend on the number of threads.
+	void testNetworkV3_batchEvaluationThreads()
+	{
+		printf("Running spike network testNetworkV3_batchEvaluationThreads\n");
+
+		const auto spikeRuntimeOptions = createBenchmarkRuntimeOptions();
+
+		using Top = spike::v3::Topology<SpikeOptionsInferenceOnly>;
+
+		auto topology = std::make_shared<Top>();
+		topology->init_mnist();
+		const spike::v3::BatchEvaluator<Top> evaluator(SpikeOptionsInferenceOnly(), spikeRuntimeOptions, topology, loadMnistSpikeStream<Top>(spikeRuntimeOptions));
+
+		const int nThreads = 2 * SpikeOptionsInferenceOnly::maxNumberOfThreads;
+		const std::string confusionMatrix1 = evaluator.evaluate(1).toStringConfusionMatrix();
+		const std::string confusionMatrix2 = evaluator.evaluate(nThreads).toStringConfusionMatrix();
+		if (confusionMatrix1 != confusionMatrix2)
+		{
+			std::cerr << "spike::testNetworkV3_batchEvaluationThreads: ERROR: the result with 1 thread differs from the result with " << nThreads << " threads" << std::endl;
+			std::cerr << confusionMatrix1 << std::endl << confusionMatrix2 << std::endl;
+			throw std::runtime_error("batch evaluation depends on the number of threads");
+		}
+		printf("spike::testNetworkV3_batchEvaluationThreads: equal results with 1 and %d threads\n", nThreads);
+	}
+
+	struct SpikeOptionsDeferredWeights : spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>
+	{
+		static const bool deferWeightUpdates = true;
+	};
+
+	// train a network from the initial MNIST topology for nSeconds and return the avg precision of its pathways with frozen weights
+	template <typename Top>
+	double trainAndEvaluate(const v0::SpikeRuntimeOptions& spikeRuntimeOptions, const unsigned int nSeconds, const int nThreads)
+	{
+		using TopInference = spike::v3::Topology<SpikeOptionsInferenceOnly>;
+
+		resetRandomGenerators();
+		auto topology = std::make_shared<Top>();
+		topology->init_mnist();
+		spike::v3::Network3<Top, spike::v3::SpikeStreamDataSet<Top>, spike::v3::IncommingSpikeQueueCalendar<Top>, spike::v3::SynapsesSparse<Top>> net(typename Top::Options(), spikeRuntimeOptions);
+		net.setTopology(topology);
+		net.setSpikeStream(loadMnistSpikeStream<Top>(spikeRuntimeOptions));
+		net.mainLoop(nSeconds, false);
+
+		const spike::v3::BatchEvaluator<TopInference, spike::v3::IncommingSpikeQueueCalendar<TopInference>, spike::v3::SynapsesSparse<TopInference>> evaluator(SpikeOptionsInferenceOnly(), spikeRuntimeOptions, copyTopology<TopInference>(net.getTopology()), loadMnistSpikeStream<TopInference>(spikeRuntimeOptions));
+		return evaluator.evaluate(nThreads).getAveragePrecision();
+	}
+
+	// learning curves of immediate and deferred (Options::deferWeightUpdates) weight updates: the avg precision of the frozen
+	// pathways after an increasing training time, both runs from the same initial topology and random streams
+	void testNetworkV3_deferredWeightUpdatesComparison()
+	{
+		printf("Running spike network testNetworkV3_deferredWeightUpdatesComparison\n");
+
+		const auto spikeRuntimeOptions = createBenchmarkRuntimeOptions();
+
+		using Top1 = spike::v3::Topology<spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>>;
+		using Top2 = spike::v3::Topology<SpikeOptionsDeferredWeights>;
+
+		const int nThreads = 4;
+		for (const unsigned int nSeconds : { 0, 15, 30, 60, 120 })
+		{
+			const double precision1 = trainAndEvaluate<Top1>(spikeRuntimeOptions, nSeconds, nThreads);
+			const double precision2 = trainAndEvaluate<Top2>(spikeRuntimeOptions, nSeconds, nThreads);
+			printf("spike::testNetworkV3_deferredWeightUpdatesComparison: trained %4u s: avg precision immediate %5.4f; deferred %5.4f\n", nSeconds, precision1, precision2);
+		}
+	}
+
+	struct SpikeOptionsFirstSpikes : SpikeOptionsInferenceOnly
+	{
+		static const spike::v3::DecisionPolicy decisionPolicy = spike::v3::DecisionPolicy::FIRST_SPIKES;
+		static const unsigned int decisionSpikes = 1;
+	};
+
+	struct SpikeOptionsMargin : SpikeOptionsInferenceOnly
+	{
+		static const spike::v3::DecisionPolicy decisionPolicy = spike::v3::DecisionPolicy::MARGIN;
+		static const unsigned int decisionSpikes = 1;
+	};
+
+	void testNetworkV3_decisionPolicyBenchmark()
+	{
+		printf("Running spike network testNetworkV3_decisionPolicyBenchmark\n");
+
+		const auto spikeRuntimeOptions = createBenchmarkRuntimeOptions();
+
+		using Top1 = spike::v3::Topology<spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>>;
+		using Top2 = spike::v3::Topology<SpikeOptionsInferenceOnly>;
+		using Top3 = spike::v3::Topology<SpikeOptionsFirstSpikes>;
+		using Top4 = spike::v3::Topology<SpikeOptionsMargin>;
+
+		//1] train
+		const unsigned int nSecondsTrain = 1 * 1 * 60;
+		auto topology1 = std::make_shared<Top1>();
+		topology1->init_mnist();
+		spike::v3::Network3<Top1, spike::v3::SpikeStreamDataSet<Top1>, spike::v3::IncommingSpikeQueueCalendar<Top1>, spike::v3::SynapsesSparse<Top1>> net(Top1::Options(), spikeRuntimeOptions);
+		net.setTopology(topology1);
+		net.setSpikeStream(loadMnistSpikeStream<Top1>(spikeRuntimeOptions));
+		net.mainLoop(nSecondsTrain, false);
+
+		//2] evaluate the same pathways with the full cases and with each decision policy; every evaluation prints the simulated
+		// time per case next to the precision
+		const int nThreads = 4;
+		const auto topology = net.getTopology();
+		const auto performance2 = spike::v3::BatchEvaluator<Top2>(SpikeOptionsInferenceOnly(), spikeRuntimeOptions, copyTopology<Top2>(topology), loadMnistSpikeStream<Top2>(spikeRuntimeOptions)).evaluate(nThreads);
+		const auto performance3 = spike::v3::BatchEvaluator<Top3>(SpikeOptionsFirstSpikes(), spikeRuntimeOptions, copyTopology<Top3>(topology), loadMnistSpikeStream<Top3>(spikeRuntimeOptions)).evaluate(nThreads);
+		const auto performance4 = spike::v3::BatchEvaluator<Top4>(SpikeOptionsMargin(), spikeRuntimeOptions, copyTopology<Top4>(topology), loadMnistSpikeStream<Top4>(spikeRuntimeOptions)).evaluate(nThreads);
+		printf("spike::testNetworkV3_decisionPolicyBenchmark: avg precision: full case %5.4f; first %u spikes %5.4f; margin %u spikes %5.4f\n", performance2.getAveragePrecision(), SpikeOptionsFirstSpikes::decisionSpikes, performance3.getAveragePrecision(), SpikeOptionsMargin::decisionSpikes, performance4.getAveragePrecision());
+	}
+
+	// write the first nCases images of the MNIST training set as a text spike data set, see SpikeDataSet::loadFromFile;
+	// the pixels are rate encoded by MnistSpikeSource into cases of the case duration of the provided options
+	template <typename Options>
+	void writeMnistSpikeDataSet(
+		const std::string& filename,
+		const v0::SpikeRuntimeOptions& spikeRuntimeOptions,
+		const size_t nCases)
+	{
+		const std::string imagesFilename = sourceDir + "/../mnist data/train-images.idx3-ubyte";
+		const std::string labelsFilename = sourceDir + "/../mnist data/train-labels.idx1-ubyte";
+		const unsigned int maxSpikesPerPixel = 4;
+		const size_t lookAhead = 256;
+		v3::MnistSpikeSource<Options> spikeSource(imagesFilename, labelsFilename, spikeRuntimeOptions, v3::SpikeEncoding::RATE, maxSpikesPerPixel, lookAhead);
+		spikeSource.start();
+
+		//1] the spikes are written after the case and neuron data: keep the encoded cases
+		std::vector<v3::EncodedCase> encodedCases(std::min(nCases, spikeSource.getNumberOfCases()));
+		size_t nSpikes = 0;
+		for (v3::EncodedCase& encodedCase : encodedCases)
+		{
+			spikeSource.next(encodedCase);
+			nSpikes += encodedCase.events.size();
+		}
+
+		if (!::tools::file::mkdirTree(::tools::file::getDirectory(filename)))
+		{
+			std::cerr << "spike::writeMnistSpikeDataSet: Unable to create directory for file " << filename << std::endl;
+			throw std::runtime_error("unable to create directory");
+		}
+		std::ofstream outputFile(filename);
+		if (!outputFile.is_open())
+		{
+			std::cerr << "spike::writeMnistSpikeDataSet: Unable to open file " << filename << std::endl;
+			throw std::runtime_error("unable to open file");
+		}
+		const size_t nPixels = spikeSource.getNumberOfPixels();
+		outputFile << "#SpikeDataSet <nCases> <nNeurons> <nSpikes>" << std::endl;
+		outputFile << encodedCases.size() << " " << nPixels << " " << nSpikes << std::endl;
+
+		//2] the sensor neurons have no random spikes
+		outputFile << "#CaseData <caseId> <caseDurationInMs> <classificationLabel>" << std::endl;
+		for (const v3::EncodedCase& encodedCase : encodedCases)
+		{
+			outputFile << encodedCase.caseId << " " << spikeSource.getCaseDurationInMs() << " " << encodedCase.caseLabel << std::endl;
+		}
+		outputFile << "#NeuronData <caseId> <neuronId> <randomSpikeHz>" << std::endl;
+		for (const v3::EncodedCase& encodedCase : encodedCases)
+		{
+			for (size_t pixel = 0; pixel < nPixels; ++pixel)
+			{
+				outputFile << encodedCase.caseId << " " << pixel << " 0" << std::endl;
+			}
+		}
+
+		//3] the events are in neuronId and time order
+		outputFile << "#SpikeData <caseId> <neuronId> <timeInMs>" << std::endl;
+		for (const v3::EncodedCase& encodedCase : encodedCases)
+		{
+			for (const v3::SensorEvent& sensorEvent : encodedCase.events)
+			{
+				outputFile << encodedCase.caseId << " " << sensorEvent.neuronId << " " << Options::toTimeInMs(sensorEvent.offset) << std::endl;
+			}
+		}
+		std::cout << "spike::writeMnistSpikeDataSet: wrote " << encodedCases.size() << " cases with " << nSpikes << " spikes to " << filename << std::endl;
+	}
+
+	void testNetworkV3_mnistCaseStore()
+	{
+		printf("Running spike network testNetworkV3_mnistCaseStore\n");
+
+		auto spikeRuntimeOptions = createBenchmarkRuntimeOptions();
+		spikeRuntimeOptions.setCaseDurationInMs(100); // used when the data set is written from the IDX files
+
+		using Top = spike::v3::Topology<spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>>;
+		using Options = Top::Options;
+
+		// the full MNIST training set: 60k cases; written from the IDX files when the text data set is not present
+		const size_t nCasesToWrite = 60000;
+		std::string spikeDataSetFilename = sourceDir + "/../mnist data/28x28/SpikeDataSetMnist-train-28x28.txt";
+		if (!std::ifstream(spikeDataSetFilename).good())
+		{
+			spikeDataSetFilename = tempDir + "/mnist/SpikeDataSetMnist-train-" + std::to_string(nCasesToWrite) + ".txt";
+			if (!std::ifstream(spikeDataSetFilename).good())
+			{
+				writeMnistSpikeDataSet<Options>(spikeDataSetFilename, spikeRuntimeOptions, nCasesToWrite);
+			}
+		}
+
+		const auto t1 = std::chrono::steady_clock::now();
+		v3::SpikeDataSet<Options> spikeDataSet;
+		spikeDataSet.loadFromFile(spikeDataSetFilename);
+		const auto t2 = std::chrono::steady_clock::now();
+
+		// addSpikeDataSet reports the load time and memory usage of the case store
+		const auto spikeStream = std::make_shared<v3::SpikeStreamDataSet<Top>>(spikeRuntimeOptions);
+		spikeStream->addSpikeDataSet(spikeDataSet);
+
+		// the footprint of the same cases as one SpikeCase each: a vector of spike times per neuron, and a rate and neuronId per neuron
+		const size_t nCases = spikeStream->getNumberOfCases();
+		const size_t nSpikes = spikeStream->getCaseStore().getNumberOfEvents();
+		const double MB = 1024 * 1024;
+		const double spikeCaseBytes = static_cast<double>(nCases) * Options::nNeurons * (sizeof(std::vector<v3::TimeInMs>) + sizeof(float) + sizeof(v3::NeuronId)) + static_cast<double>(nSpikes) * (sizeof(v3::TimeInMs) + sizeof(v3::SensorEvent));
+		printf("spike::testNetworkV3_mnistCaseStore: parsing %zu cases took %.0f ms; case store %.1f MB; as SpikeCases at least %.1f MB\n", nCases, std::chrono::duration<double, std::milli>(t2 - t1).count(), spikeStream->getCaseStore().getMemoryUsage() / MB, spikeCaseBytes / MB);
+	}
+
+	void testNetworkV3_mnistBinaryDataSet()
+	{
+		printf("Running spike network testNetworkV3_mnistBinaryDataSet\n");
+
+		const auto spikeRuntimeOptions = createBenchmarkRuntimeOptions();
+
+		using Top = spike::v3::Topology<spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>>;
+
+		// convert the text data set once; every later run (or concurrent process) maps the binary file
+		const std::string spikeDataSetFilename = sourceDir + "/../mnist data/28x28/SpikeDataSetMnist-train-28x28.txt";
+		const std::string binaryFilename = tempDir + "/mnist/SpikeDataSetMnist-train-28x28.bin";
+		if (!std::ifstream(binaryFilename).good())
+		{
+			v3::SpikeDataSetBinary<Top>::convertFromTextFile(spikeDataSetFilename, binaryFilename);
+		}
+
+		// addSpikeDataSet reports the load time, the memory usage of the case store and the mapped size
+		const auto spikeDataSet = std::make_shared<const v3::SpikeDataSetBinary<Top>>(binaryFilename);
+		const auto spikeStream = std::make_shared<v3::SpikeStreamDataSet<Top>>(spikeRuntimeOptions);
+		spikeStream->addSpikeDataSet(spikeDataSet);
+	}
+
+	void testNetworkV3_mnistOnline()
+	{
+		printf("Running spike network testNetworkV3_mnistOnline\n");
+
+		auto spikeRuntimeOptions = createBenchmarkRuntimeOptions();
+		spikeRuntimeOptions.setCaseDurationInMs(100); // the online source encodes every image into a case of this duration
+
+		using Top = spike::v3::Topology<spike::v3::SpikeOptionsStatic<800, 200, 28 * 28, 10>>;
+
+		const unsigned int nSeconds = 1 * 1 * 60;
+		auto topology = std::make_shared<Top>();
+		topology->init_mnist();
+		spike::v3::Network3<Top, spike::v3::SpikeStreamDataSet<Top>, spike::v3::IncommingSpikeQueueCalendar<Top>, spike::v3::SynapsesSparse<Top>> net(Top::Options(), spikeRuntimeOptions);
+		net.setTopology(topology);
+		net.setSpikeStream(createMnistSpikeStreamOnline<Top>(spikeRuntimeOptions, spike::v3::SpikeEncoding::RATE));
+		net.mainLoop(nSeconds, false);
+	}
+
 	void testNetworkV3_masquelier()
 	{
 		printf("Running spike network testNetworkV3_masquelier\n");
@@ -506,6 +1160,19 @@ int main(int /*argc*/, char** /*argv[]*/)
 	spike::testNetworkV0_masquelier("now"); // works
 
 	//spike::testNetworkV3_mnist();
+	//spike::testNetworkV3_mnist_threadScaling();
+	//spike::testNetworkV3_spikeQueueBenchmark();
+	//spike::testNetworkV3_voltageEngineBenchmark();
+	//spike::testNetworkV3_skipSilentWindowsBenchmark();
+	//spike::testNetworkV3_plasticityEngineBenchmark();
+	//spike::testNetworkV3_inferenceOnlyBenchmark();
+	//spike::testNetworkV3_mnistBatchEvaluation();
+	//spike::testNetworkV3_batchEvaluationThreads();
+	//spike::testNetworkV3_deferredWeightUpdatesComparison();
+	//spike::testNetworkV3_decisionPolicyBenchmark();
+	//spike::testNetworkV3_mnistCaseStore();
+	//spike::testNetworkV3_mnistBinaryDataSet();
+	//spike::testNetworkV3_mnistOnline();
 	//spike::testNetworkV3_masquelier();
 	//spike::runExperiments();
 
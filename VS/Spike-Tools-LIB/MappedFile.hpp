@@ -0,0 +1,146 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <string>
+#include <iostream>		// std::cerr
+#include <stdexcept>	// std::runtime_error
+#include <cstddef>		// size_t
+
+#if defined(_WIN32)
+#	if !defined(WIN32_LEAN_AND_MEAN)
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	if !defined(NOMINMAX)
+#		define NOMINMAX 1
+#	endif
+#	include <windows.h>
+#else
+#	include <fcntl.h>		// open
+#	include <unistd.h>		// close
+#	include <sys/mman.h>	// mmap, munmap
+#	include <sys/stat.h>	// fstat
+#endif
+
+namespace spike
+{
+	namespace tools
+	{
+		// Read-only memory mapping of a whole file. The pages are shared with every other process that maps the same file,
+		// hence concurrent processes that read the same data set use one copy in the page cache.
+		class MappedFile
+		{
+		public:
+
+			// constructor
+			MappedFile(const std::string& filename)
+				: data_(nullptr)
+				, size_(0)
+			{
+#if defined(_WIN32)
+				this->file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				if (this->file_ == INVALID_HANDLE_VALUE)
+				{
+					std::cerr << "spike::tools::MappedFile: Unable to open file " << filename << std::endl;
+					throw std::runtime_error("unable to open file");
+				}
+				LARGE_INTEGER size;
+				GetFileSizeEx(this->file_, &size);
+				this->size_ = static_cast<size_t>(size.QuadPart);
+				this->mapping_ = CreateFileMappingA(this->file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (this->mapping_ != nullptr)
+				{
+					this->data_ = MapViewOfFile(this->mapping_, FILE_MAP_READ, 0, 0, 0);
+				}
+#else
+				this->file_ = open(filename.c_str(), O_RDONLY);
+				if (this->file_ == -1)
+				{
+					std::cerr << "spike::tools::MappedFile: Unable to open file " << filename << std::endl;
+					throw std::runtime_error("unable to open file");
+				}
+				struct stat status;
+				fstat(this->file_, &status);
+				this->size_ = static_cast<size_t>(status.st_size);
+				if (this->size_ > 0)
+				{
+					void * const data = mmap(nullptr, this->size_, PROT_READ, MAP_SHARED, this->file_, 0);
+					this->data_ = (data == MAP_FAILED) ? nullptr : data;
+				}
+#endif
+				if (this->data_ == nullptr)
+				{
+					std::cerr << "spike::tools::MappedFile: Unable to map file " << filename << std::endl;
+					this->unmap();
+					throw std::runtime_error("unable to map file");
+				}
+			}
+
+			// destructor
+			~MappedFile()
+			{
+				this->unmap();
+			}
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			const char * data() const
+			{
+				return static_cast<const char *>(this->data_);
+			}
+
+			size_t size() const
+			{
+				return this->size_;
+			}
+
+		private:
+
+			void * data_;
+			size_t size_;
+#if defined(_WIN32)
+			HANDLE file_;
+			HANDLE mapping_ = nullptr;
+#else
+			int file_;
+#endif
+
+			void unmap()
+			{
+#if defined(_WIN32)
+				if (this->data_ != nullptr) UnmapViewOfFile(this->data_);
+				if (this->mapping_ != nullptr) CloseHandle(this->mapping_);
+				if (this->file_ != INVALID_HANDLE_VALUE) CloseHandle(this->file_);
+				this->mapping_ = nullptr;
+				this->file_ = INVALID_HANDLE_VALUE;
+#else
+				if (this->data_ != nullptr) munmap(this->data_, this->size_);
+				if (this->file_ != -1) close(this->file_);
+				this->file_ = -1;
+#endif
+				this->data_ = nullptr;
+			}
+		};
+	}
+}
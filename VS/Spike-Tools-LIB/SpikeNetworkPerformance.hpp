@@ -150,6 +150,21 @@ namespace spike
 				//	//DEBUG_BREAK();
 			}
 
+			// add a case of which the number of propagated spikes of every motor neuron is known, see spike::v3::BatchEvaluator
+			void addPerformance(
+				const CaseLabel correctLabel,
+				const std::array<unsigned int, S>& motorSpikeCount)
+			{
+				this->nTimesCasesIsPresented_[correctLabel.val]++;
+				for (CaseLabelType observedLabel = 0; observedLabel < S; ++observedLabel)
+				{
+					if (motorSpikeCount[observedLabel] > 0)
+					{
+						this->confusionMatrix_[this->index(observedLabel, correctLabel.val)]++;
+					}
+				}
+			}
+
 			std::string toStringConfusionMatrix() const
 			{
 				std::ostringstream oss;
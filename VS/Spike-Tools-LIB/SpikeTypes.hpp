@@ -107,13 +107,17 @@ namespace spike
 		Time startTime_;
 		Time endTime_;
 		CaseLabelType caseLabel_;
+		CaseLabelType decisionLabel_; // label decided by the decision policy of the network, NO_CASE_LABEL if the case ended without decision
+		Time decisionLatency_; // time from the start of the case to the decision
 
 		// default constructor
 		CaseOccurance()
-			: caseId_(NO_CASE_ID)
+			: caseId_(NO_CASE_ID.val)
 			, startTime_(0)
 			, endTime_(0)
-			, caseLabel_(NO_CASE_LABEL)
+			, caseLabel_(NO_CASE_LABEL.val)
+			, decisionLabel_(NO_CASE_LABEL.val)
+			, decisionLatency_(0)
 		{
 		}
 
@@ -123,13 +127,15 @@ namespace spike
 			, startTime_(startTime)
 			, endTime_(endTime)
 			, caseLabel_(caseLabel.val)
+			, decisionLabel_(NO_CASE_LABEL.val)
+			, decisionLatency_(0)
 		{
 		}
 
 		std::string toString() const
 		{
 			std::ostringstream oss;
-			oss << "CaseOccurance(caseId " << this->caseId_ << "(" << this->caseLabel_ << "); startTime " << this->startTime_ << "; endTime " << this->endTime_ << ")";
+			oss << "CaseOccurance(caseId " << this->caseId_ << "(" << this->caseLabel_ << "); startTime " << this->startTime_ << "; endTime " << this->endTime_ << "; decision " << this->decisionLabel_ << "; latency " << this->decisionLatency_ << ")";
 			return oss.str();
 		}
 	};
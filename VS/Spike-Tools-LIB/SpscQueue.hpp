@@ -0,0 +1,107 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 Henk-Jan Lebbink
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <utility>	// std::move
+#include <cstddef>	// size_t
+
+namespace spike
+{
+	namespace tools
+	{
+		// Bounded lock-free queue for exactly one producer thread and one consumer thread. The elements are kept in a ring of
+		// capacity + 1 slots; the producer only writes tail_ and the consumer only writes head_, each with release semantics
+		// such that the other thread sees the element before it sees the index move.
+		template <typename T>
+		class SpscQueue
+		{
+		public:
+
+			// constructor
+			SpscQueue(const size_t capacity)
+				: slots_(std::vector<T>(capacity + 1))
+				, head_(0)
+				, tail_(0)
+			{
+			}
+
+			SpscQueue(const SpscQueue&) = delete;
+			SpscQueue& operator=(const SpscQueue&) = delete;
+
+			// producer: move the provided element into the queue; return false (and leave the element) when the queue is full
+			bool tryPush(T& element)
+			{
+				const size_t tail = this->tail_.load(std::memory_order_relaxed);
+				const size_t next = this->increment(tail);
+				if (next == this->head_.load(std::memory_order_acquire))
+				{
+					return false;
+				}
+				this->slots_[tail] = std::move(element);
+				this->tail_.store(next, std::memory_order_release);
+				return true;
+			}
+
+			// consumer: move the oldest element into the provided element; return false when the queue is empty
+			bool tryPop(T& element)
+			{
+				const size_t head = this->head_.load(std::memory_order_relaxed);
+				if (head == this->tail_.load(std::memory_order_acquire))
+				{
+					return false;
+				}
+				element = std::move(this->slots_[head]);
+				this->head_.store(this->increment(head), std::memory_order_release);
+				return true;
+			}
+
+			// the number of elements; exact only when called by the producer or consumer while the other is idle
+			size_t size() const
+			{
+				const size_t head = this->head_.load(std::memory_order_acquire);
+				const size_t tail = this->tail_.load(std::memory_order_acquire);
+				return (tail >= head) ? (tail - head) : (tail + this->slots_.size() - head);
+			}
+
+			size_t capacity() const
+			{
+				return this->slots_.size() - 1;
+			}
+
+		private:
+
+			std::vector<T> slots_;
+
+			// head_ and tail_ on separate cache lines: they are written by different threads
+			alignas(64) std::atomic<size_t> head_; // next slot to pop, written by the consumer
+			alignas(64) std::atomic<size_t> tail_; // next slot to push, written by the producer
+
+			size_t increment(const size_t i) const
+			{
+				return ((i + 1) == this->slots_.size()) ? 0 : (i + 1);
+			}
+		};
+	}
+}
@@ -114,6 +114,13 @@ namespace tools
 			}
 		}
 
+		// restart the random numbers of rand_int32 and rand_float without a random_number argument; seed may not be zero
+		inline void set_seed(const unsigned int seed)
+		{
+			tools::assert::assert_msg(seed != 0, "tools::random::set_seed: seed may not be zero");
+			random::priv::current_random_number = seed;
+		}
+
 		inline unsigned int next_rand(const unsigned int i)
 		{
 			return random::priv::lfsr32_galois_ref(i);